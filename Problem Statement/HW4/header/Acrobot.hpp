@@ -5,15 +5,26 @@
 // Acrobot MDP - see Gridworld.hpp for comments regarding the general structure of these environment/MDP objects
 class Acrobot {
 public:
+	// The shape is fixed, so the state can be a std::array: the static agents take it directly (see ObservationType.hpp). The
+	// other agents take the std::vector<double> Observation, which getState also writes.
+	static constexpr int stateDim = 4;
+	static constexpr int numActions = 3;
+	typedef std::array<double, stateDim> State;
+	typedef std::vector<double> Observation;	// The state type runExperiment uses (see Gridworld.hpp)
 	Acrobot();
 	int getStateDim() const;
 	int getNumActions() const;
 	double update(const int & action, std::mt19937_64 & generator);
 	std::vector<double> getState(std::mt19937_64 & generator);
+	void getState(std::mt19937_64 & generator, std::vector<double> & result);
+	void getState(std::mt19937_64 & generator, State & result);
 	bool inTerminalState() const;
 	void newEpisode(std::mt19937_64 & generator);
 
 private:
+	// Write the normalized state to result[0..stateDim-1].
+	void writeState(double * result) const;
+
 	// Standard parameters for the acrobot domain
 	const double m1 = 1;				// Mass of the first link
 	const double m2 = 1;				// Mass of the second link
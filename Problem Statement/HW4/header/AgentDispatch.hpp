@@ -0,0 +1,69 @@
+#pragma once
+
+#include "stdafx.h"
+
+// Choosing between the compile-time specialized agents (StaticQLearning, StaticSarsa) and the dynamic ones (QLearning, Sarsa) at
+// runtime. A specialization has to be compiled for every (stateDim, iOrder, dOrder) it is used with, so only the configurations
+// listed in PrebuiltBasisConfigs are available; every other configuration runs on the dynamic agents, with the same results.
+
+// One (stateDim, iOrder, dOrder) configuration, and a list of them.
+template <int StateDim, int IOrder, int DOrder> struct BasisConfig {};
+template <typename... Configs> struct BasisConfigList {};
+
+// The configurations that have a prebuilt specialization: the ones main.cpp uses for MountainCar (stateDim 2) and for CartPole and
+// Acrobot (stateDim 4). Add to this list to prebuild more (each entry adds one instantiation of runExperiment per agent and environment).
+typedef BasisConfigList<
+	BasisConfig<2, 1, 1>, BasisConfig<2, 5, 0>,
+	BasisConfig<4, 1, 1>, BasisConfig<4, 2, 0>, BasisConfig<4, 4, 0>
+> PrebuiltBasisConfigs;
+
+// Walks the list, constructing StaticAgent<S, I, D> for the first entry that matches, or DynamicAgent if none does.
+template <template <int, int, int> class StaticAgent, typename DynamicAgent, typename List>
+struct AgentDispatcher;
+
+template <template <int, int, int> class StaticAgent, typename DynamicAgent>
+struct AgentDispatcher<StaticAgent, DynamicAgent, BasisConfigList<>> {
+	static bool has(const int &, const int &, const int &) {
+		return false;
+	}
+	template <typename Visitor>
+	static void run(const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & iOrder, const int & dOrder, Visitor && visitor) {
+		DynamicAgent agent(stateDim, numActions, alpha, gamma, epsilon, iOrder, dOrder);
+		visitor(agent);
+	}
+};
+
+template <template <int, int, int> class StaticAgent, typename DynamicAgent, int S, int I, int D, typename... Rest>
+struct AgentDispatcher<StaticAgent, DynamicAgent, BasisConfigList<BasisConfig<S, I, D>, Rest...>> {
+	static bool has(const int & stateDim, const int & iOrder, const int & dOrder) {
+		return ((stateDim == S) && (iOrder == I) && (dOrder == D)) || AgentDispatcher<StaticAgent, DynamicAgent, BasisConfigList<Rest...>>::has(stateDim, iOrder, dOrder);
+	}
+	template <typename Visitor>
+	static void run(const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & iOrder, const int & dOrder, Visitor && visitor) {
+		if ((stateDim == S) && (iOrder == I) && (dOrder == D)) {
+			StaticAgent<S, I, D> agent(stateDim, numActions, alpha, gamma, epsilon, iOrder, dOrder);
+			visitor(agent);
+		}
+		else
+			AgentDispatcher<StaticAgent, DynamicAgent, BasisConfigList<Rest...>>::run(stateDim, numActions, alpha, gamma, epsilon, iOrder, dOrder, visitor);
+	}
+};
+
+// Does (stateDim, iOrder, dOrder) have a prebuilt specialization?
+inline bool hasStaticBasis(const int & stateDim, const int & iOrder, const int & dOrder) {
+	return AgentDispatcher<StaticQLearning, QLearning, PrebuiltBasisConfigs>::has(stateDim, iOrder, dOrder);
+}
+
+// Construct a Q-learning agent with the given arguments (the same as QLearning's constructor) and call visitor(agent) with it.
+// The agent is a StaticQLearning if the configuration is prebuilt, and a QLearning otherwise, so visitor must accept either: use
+// a generic lambda, e.g. [&](auto & agent) { runExperiment(agent, ...); }.
+template <typename Visitor>
+void withQLearningAgent(const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & iOrder, const int & dOrder, Visitor && visitor) {
+	AgentDispatcher<StaticQLearning, QLearning, PrebuiltBasisConfigs>::run(stateDim, numActions, alpha, gamma, epsilon, iOrder, dOrder, visitor);
+}
+
+// Same as above, for Sarsa.
+template <typename Visitor>
+void withSarsaAgent(const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & iOrder, const int & dOrder, Visitor && visitor) {
+	AgentDispatcher<StaticSarsa, Sarsa, PrebuiltBasisConfigs>::run(stateDim, numActions, alpha, gamma, epsilon, iOrder, dOrder, visitor);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "stdafx.h"
+
+// Alignment (in bytes) of all buffers that are read by the vectorized loops. 64 bytes is one cache line, and is enough for AVX-512.
+const std::size_t simdAlignment = 64;
+
+// A std::allocator replacement that returns memory aligned to simdAlignment bytes. Use through the AlignedVector typedef below.
+template <typename T>
+class AlignedAllocator {
+public:
+	typedef T value_type;
+
+	AlignedAllocator() {}
+	template <typename U> AlignedAllocator(const AlignedAllocator<U> &) {}
+
+	T * allocate(std::size_t n) {
+		if (n == 0)
+			return nullptr;
+		void * p = nullptr;
+#ifdef _MSC_VER
+		p = _aligned_malloc(n * sizeof(T), simdAlignment);
+#else
+		if (posix_memalign(&p, simdAlignment, n * sizeof(T)) != 0)
+			p = nullptr;
+#endif
+		if (p == nullptr)
+			throw std::bad_alloc();
+		return static_cast<T *>(p);
+	}
+
+	void deallocate(T * p, std::size_t) {
+#ifdef _MSC_VER
+		_aligned_free(p);
+#else
+		free(p);
+#endif
+	}
+
+	template <typename U> struct rebind { typedef AlignedAllocator<U> other; };
+};
+
+template <typename T, typename U>
+bool operator==(const AlignedAllocator<T> &, const AlignedAllocator<U> &) { return true; }
+
+template <typename T, typename U>
+bool operator!=(const AlignedAllocator<T> &, const AlignedAllocator<U> &) { return false; }
+
+// An std::vector whose data() is aligned to simdAlignment bytes.
+typedef std::vector<double, AlignedAllocator<double>> AlignedVector;
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "stdafx.h"
+
+// AllocationCounter.cpp replaces the global operator new so that every heap allocation is counted, per thread (one increment of a
+// thread-local counter per allocation). runExperiment asserts with it, in debug builds, that its steady-state steps never touch the
+// heap, and "--check-allocations" checks the same in every build (see checkAllocations in Benchmarks.hpp). Define
+// NO_COUNT_ALLOCATIONS to keep the standard operator new.
+#ifndef NO_COUNT_ALLOCATIONS
+#define COUNT_ALLOCATIONS
+#endif
+
+// Number of heap allocations made by the calling thread so far. Always 0 when COUNT_ALLOCATIONS is not defined.
+long long getThreadAllocationCount();
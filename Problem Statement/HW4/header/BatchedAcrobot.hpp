@@ -0,0 +1,65 @@
+#pragma once
+
+#include "stdafx.h"
+
+/*
+numLanes Acrobot environments stepped together, in structure-of-arrays layout. Each evaluation of the dynamics in the Runge-Kutta
+integration is a pass of the C math library's sin and cos over the lanes, then one vectorizable pass of the arithmetic, so each
+lane stays bit-identical to an Acrobot given the same actions. Lanes are masked as in BatchedMountainCar (see BatchedMountainCar.hpp
+for the interface).
+*/
+class BatchedAcrobot {
+public:
+	static constexpr int stateDim = Acrobot::stateDim;
+	static constexpr int numActions = Acrobot::numActions;
+	typedef Acrobot::State State;
+
+	explicit BatchedAcrobot(const int & numLanes);
+
+	int getNumLanes() const;
+	int getStateDim() const;
+	int getNumActions() const;
+
+	void update(const int * actions, const unsigned char * active, double * rewards);
+	void update(const int * actions, double * rewards);
+
+	void getStates(double * result) const;
+	void getState(const int & lane, State & result) const;
+
+	const unsigned char * getTerminalMask() const;
+	bool inTerminalState(const int & lane) const;
+
+	void newEpisode(const unsigned char * reset);
+	void newEpisode();
+
+private:
+	// Acrobot::f for every lane. s and buff hold the 4 components of each lane in structure-of-arrays layout: component j of lane k
+	// at [j*numLanes + k]. tau has one element per lane.
+	void f(const double * s, const double * tau, double * buff);
+
+	// Recompute terminal from the state.
+	void updateTerminal();
+
+	// Standard parameters for the acrobot domain (the same as in Acrobot.hpp)
+	const double m1 = 1;				// Mass of the first link
+	const double m2 = 1;				// Mass of the second link
+	const double l1 = 1;				// Length of the first link
+	const double l2 = 1;				// Length of the second link
+	const double lc1 = .5;
+	const double lc2 = .5;
+	const double i1 = 1;
+	const double i2 = 1;
+	const double g = 9.8;				// Acceleration due to gravity
+	const double fmax = 1;				// Maximum (and -minimum) force that can be applied
+	const double dt = 0.2;				// Time step duration
+	const double integShritte = 10;		// The larger this is, the more accurate the Runge-Kutta approximation
+
+	int numLanes;
+	AlignedVector t, theta1, theta2, theta1Dot, theta2Dot;	// The state of each lane
+
+	// Runge-Kutta buffers, 4 components per lane (see f), and the cosines and sines that f takes from the math library
+	AlignedVector hilf, s1, s2, s3, s0_dot, s1_dot, s2_dot, s3_dot;
+	AlignedVector u, cosS1, sinS1, cosPhi1, cosPhi2;
+	std::vector<unsigned char> terminal;
+	std::vector<unsigned char> allLanes;	// A mask with every lane set
+};
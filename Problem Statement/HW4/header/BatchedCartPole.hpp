@@ -0,0 +1,66 @@
+#pragma once
+
+#include "stdafx.h"
+
+/*
+numLanes CartPole environments stepped together, in structure-of-arrays layout. Each of the simSteps Euler sub-steps of update is
+a pass of the C math library's sin and cos over the lanes, then one vectorizable pass of the dynamics, then the angle wrap, so each
+lane stays bit-identical to a CartPole given the same actions. Lanes are masked as in BatchedMountainCar (see BatchedMountainCar.hpp
+for the interface).
+*/
+class BatchedCartPole {
+public:
+	static constexpr int stateDim = CartPole::stateDim;
+	static constexpr int numActions = CartPole::numActions;
+	typedef CartPole::State State;
+
+	explicit BatchedCartPole(const int & numLanes);
+
+	int getNumLanes() const;
+	int getStateDim() const;
+	int getNumActions() const;
+
+	void update(const int * actions, const unsigned char * active, double * rewards);
+	void update(const int * actions, double * rewards);
+
+	void getStates(double * result) const;
+	void getState(const int & lane, State & result) const;
+
+	const unsigned char * getTerminalMask() const;
+	bool inTerminalState(const int & lane) const;
+
+	void newEpisode(const unsigned char * reset);
+	void newEpisode();
+
+private:
+	// Recompute terminal from the state.
+	void updateTerminal();
+
+	// Standard parameters for the CartPole domain (the same as in CartPole.hpp)
+	const int simSteps = 10;
+	const double dt = 0.02;
+	const double uMax = 10.0;
+	const double l = 0.5;
+	const double g = 9.8;
+	const double m = 0.1;
+	const double mc = 1;
+	const double muc = 0.0005;
+	const double mup = 0.000002;
+
+	// State variables ranges
+	const double xMin = -2.4;
+	const double xMax = 2.4;
+	const double vMin = -10;
+	const double vMax = 10;
+	const double thetaMin = -M_PI / 12.0;
+	const double thetaMax = M_PI / 12.0;
+	const double omegaMin = -M_PI;
+	const double omegaMax = M_PI;
+
+	int numLanes;
+	AlignedVector x, v, theta, omega, t;		// The state of each lane
+	AlignedVector newX, newV, newTheta, newOmega, newT;	// The state being stepped, during update
+	AlignedVector sinTheta, cosTheta;			// Of newTheta, during a sub-step
+	std::vector<unsigned char> terminal;
+	std::vector<unsigned char> allLanes;		// A mask with every lane set
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "stdafx.h"
+
+/*
+numLanes MountainCar environments stepped together. The state is held in structure-of-arrays layout (all of the x values, then
+all of the xDot values, in aligned buffers), so update steps every lane with one pass of straight-line arithmetic over the lanes,
+which the compiler vectorizes. The cosine goes through the C math library one lane at a time, in its own pass, so that each lane
+follows exactly the same trajectory as a MountainCar given the same actions: the states, rewards and terminal flags are
+bit-identical (see "--benchmark batched").
+
+Lanes are masked: update only steps the lanes marked active, and newEpisode only resets the lanes marked in its mask, so lanes
+whose episode ended can wait, or start over, while the others keep going. Masks are arrays of numLanes bytes, nonzero for true.
+The environment is deterministic, so unlike MountainCar the functions take no random number generator.
+*/
+class BatchedMountainCar {
+public:
+	static constexpr int stateDim = MountainCar::stateDim;
+	static constexpr int numActions = MountainCar::numActions;
+	typedef MountainCar::State State;
+
+	// numLanes environments, each at the start of an episode.
+	explicit BatchedMountainCar(const int & numLanes);
+
+	int getNumLanes() const;
+	int getStateDim() const;
+	int getNumActions() const;
+
+	// Apply actions[lane] in each lane where active[lane] is nonzero, and write its reward to rewards[lane]. The other lanes are
+	// left as they are, with a reward of 0. The second version steps every lane.
+	void update(const int * actions, const unsigned char * active, double * rewards);
+	void update(const int * actions, double * rewards);
+
+	// The normalized states (as MountainCar::getState), row-major numLanes x stateDim (lane l at result[l*stateDim], the layout
+	// FourierBasis::basifyBatch reads), or the state of one lane.
+	void getStates(double * result) const;
+	void getState(const int & lane, State & result) const;
+
+	// terminal[lane] is nonzero when the lane is in a terminal state.
+	const unsigned char * getTerminalMask() const;
+	bool inTerminalState(const int & lane) const;
+
+	// Start a new episode in the lanes where reset[lane] is nonzero, or in every lane.
+	void newEpisode(const unsigned char * reset);
+	void newEpisode();
+
+private:
+	// Recompute terminal from x.
+	void updateTerminal();
+
+	const double minX = -1.2;
+	const double maxX = 0.5;
+	const double minXDot = -0.07;
+	const double maxXDot = 0.07;
+
+	int numLanes;
+	AlignedVector x, xDot;						// The state of each lane (not normalized)
+	AlignedVector slope;						// cos(3x) of each lane, during update
+	std::vector<unsigned char> terminal;
+	std::vector<unsigned char> allLanes;		// A mask with every lane set
+};
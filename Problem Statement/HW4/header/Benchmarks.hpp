@@ -0,0 +1,86 @@
+#pragma once
+
+#include "stdafx.h"
+
+// Micro-benchmarks for the hot loops. These are not run by default: start the program as "<executable> --benchmark <name>",
+// where <name> is one of the names listed in runBenchmark (see Benchmarks.cpp). Results are printed to std::cout.
+
+// Run the benchmark called name. Returns false if there is no benchmark with that name.
+bool runBenchmark(const std::string & name);
+
+// Terms/sec of FourierBasis::basify against the original vector-of-rows implementation, for stateDim 2 and 4, iOrder 1-9 and dOrder 0-3.
+void benchmarkBasify();
+
+// Throughput and accuracy of cosPi in each CosineMode and at each SimdLevel the CPU supports, for arguments in a few ranges.
+void benchmarkCosine();
+
+// Cosines per call, terms/sec and error of FourierBasis::basify with and without the harmonic recurrence, on a 4-D state.
+void benchmarkHarmonics();
+
+// Cost per feature of FourierBasis::basify with the dense and the sparse coefficient layouts, on Gridworld and Acrobot states.
+void benchmarkSparse();
+
+// Time per step of the q-value and TD-update work of an agent (q(s,a) for every action, then one weight update) with the original
+// vector-of-rows weights and with WeightMatrix, for 3 actions and a range of feature counts.
+void benchmarkWeights();
+
+// Time to compute phi(s) and q(s,a) for every action with FourierBasis and WeightMatrix, and with StaticFourierBasis and the
+// fixed-length kernels, for each configuration in PrebuiltBasisConfigs.
+void benchmarkStatic();
+
+// States/sec of FourierBasis::basifyBatch against calling basify on each state, on batches of 4096 states, with both coefficient
+// layouts and both cosine modes.
+void benchmarkBatch();
+
+// Coefficient memory, cost per feature and largest difference from the sparse layout of FourierBasis::basify with each coefficient
+// layout, for coupled blocks of up to 4^8 terms.
+void benchmarkImplicit();
+
+// Time per step of FourierBasis::basify and of IncrementalFeatures::update along random-policy trajectories of each environment,
+// how often the incremental features were recomputed, and their largest difference from basify.
+void benchmarkIncremental();
+
+// Cost per state, hit rate and error of a FeatureCache against FourierBasis::basify, with exact keys on Gridworld and MountainCar,
+// and quantized keys on MountainCar.
+void benchmarkFeatureCache();
+
+// Time per step and final return of the Fourier agents and of the tile-coding agents on MountainCar, over a range of feature counts.
+void benchmarkTileCoding();
+
+// Time per step of QLearning and Sarsa on one-hot states of growing dimension, passed as std::vector<double> and as SparseState,
+// and the largest difference between the q-values of the dense and the sparse (ShiftedWeightMatrix) weights.
+void benchmarkSparseState();
+
+// Time per step and final return on Gridworld of QLearning and Sarsa with iOrder 1 and dOrder 0, and of the tabular agents.
+void benchmarkTabular();
+
+// Memory and time per step of the tabular agents on random Gridworld maps from 100 x 100 to 10000 x 10000 cells (loaded back from
+// a binary map file), with the dense QTable (up to 1000 x 1000) and with the PagedQTable.
+void benchmarkGridMap();
+
+// Steps/sec of MountainCar, CartPole and Acrobot stepped one environment at a time and as one batched environment (see
+// BatchedMountainCar.hpp), for 1 to 1024 lanes, and whether each lane matches its scalar environment bit for bit.
+void benchmarkBatchedEnvironments();
+
+
+// Time and returns of 32 trials of QLearning and Sarsa run one at a time, as in runExperiment, and in lockstep groups of 1 to 32
+// lanes with runLockstepTrials (see LockstepRunner.hpp), and whether the returns are bit-identical.
+void benchmarkLockstep();
+
+// A 5 alpha x 5 epsilon grid search run as 25 separate runs and as one sweep with a lane per configuration (runLockstepSweep, see
+// LockstepRunner.hpp), and whether the returns are bit-identical.
+void benchmarkSweep();
+
+// Trials of QLearning and Sarsa run with a static OpenMP loop and with the work-stealing TrialScheduler (see TrialScheduler.hpp),
+// with the per-thread utilization of the scheduler and whether the returns are bit-identical.
+void benchmarkScheduler();
+
+// A small grid of configurations run one at a time with an OpenMP loop each, and as one flattened sweep on the thread pool (see
+// SweepEngine.hpp), with the pool's utilization and whether the results are bit-identical.
+void benchmarkSweepEngine();
+
+// Runs a few episodes of each agent and environment pair (and basifies sparse states with each coefficient layout), and counts the
+// heap allocations made after the first episode, when every buffer should have its final size. Prints the count for each pair and
+// returns false if any of them allocated, or if allocations are not counted in this build (see AllocationCounter.hpp). Unlike the
+// assert in runTrialEpisodes, this is also checked in release builds: start the program as "<executable> --check-allocations".
+bool checkAllocations();
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "stdafx.h"
+
+/*
+A memo of phi(x) for environments whose observations repeat, such as Gridworld, where the 25 one-hot states are basified over and
+over. Each agent copy holds its own FeatureCache (the basis is shared and read-only, see QLearning.hpp, so a cache that changes on
+every lookup cannot live in it without locking).
+
+The key is either the exact observation (bit-for-bit), in which case a hit returns exactly what basify would, or the observation
+quantized on a grid with the given cell widths, for continuous environments: x is mapped to the cell floor(x[k]/cellSize[k]),
+and the features stored for a cell are those of its center, so they do not depend on which state of the cell was seen first.
+
+At most capacity feature vectors are kept, in one preallocated buffer. When it is full, the entry to drop is chosen with the clock
+algorithm: entries are marked when they are used, and the clock hand sweeps the entries, unmarking them, until it finds one that
+has not been used since its last sweep. Lookups go through a hash table of chained entries, and never allocate.
+*/
+class FeatureCache {
+public:
+	// A disabled cache. Use reset before use.
+	FeatureCache();
+
+	// A cache of up to capacity feature vectors of basis. Leave cellSize empty to key on the exact observation, or give one cell
+	// width per input to key on the quantized observation.
+	FeatureCache(const std::shared_ptr<const FourierBasis> & basis, const int & capacity, const std::vector<double> & cellSize = std::vector<double>());
+	void reset(const std::shared_ptr<const FourierBasis> & basis, const int & capacity, const std::vector<double> & cellSize = std::vector<double>());
+
+	// Has reset been called with a positive capacity?
+	bool isEnabled() const;
+
+	// Pointer to the basis->getNumOutputs() features of x (or of its cell), computed on a miss. The pointer stays valid until the
+	// next call to lookup or reset.
+	const double * lookup(const double * x);
+
+	// result = the features of x, from the cache (result is resized to getNumOutputs()).
+	void basify(const std::vector<double> & x, std::vector<double> & result);
+
+	long long getNumHits() const;
+	long long getNumMisses() const;
+	long long getNumEvictions() const;
+
+	// Bytes held by the keys, the features and the hash table.
+	size_t getMemory() const;
+
+private:
+	// Write the key of x into key.
+	void makeKey(const double * x);
+
+	// Bucket of key.
+	int bucketOf(const unsigned long long * key) const;
+
+	// Choose an entry to reuse with the clock algorithm, and remove it from its bucket.
+	int evict();
+
+	std::shared_ptr<const FourierBasis> basis;
+	int capacity = 0, inputDimension = 0, nTerms = 0;
+	int numEntries = 0;					// Entries in use (the first numEntries)
+	std::vector<double> cellSize;		// Empty for exact keys
+
+	std::vector<unsigned long long> keys;	// keys[e*inputDimension + k]: word k of the key of entry e
+	std::vector<double> features;			// features[e*nTerms + i]: feature i of entry e
+	std::vector<int> bucketHead;			// First entry of each bucket, or -1. The number of buckets is a power of two.
+	std::vector<int> nextInBucket;			// Next entry in the same bucket, or -1
+	std::vector<int> entryBucket;			// Bucket of each entry
+	std::vector<unsigned char> referenced;	// Clock marks
+	int clockHand = 0;
+
+	std::vector<unsigned long long> key;	// The key being looked up
+	std::vector<double> center;				// The center of its cell (quantized keys only)
+
+	long long numHits = 0, numMisses = 0, numEvictions = 0;
+};
@@ -2,16 +2,193 @@
 
 #include "stdafx.h"
 
+// How the coefficient matrix C is stored (see FourierBasis::setCoefficientLayout).
+enum class CoefficientLayout { Dense, Sparse, Implicit };
+
 // A class implementing the Fourier basis
 class FourierBasis
 {
 public:
 	void init(const int & inputDimension, int iOrder, int dOrder);
+
+	// The coupled (dependent) block has (dOrder+1)^inputDimension terms, which explodes for high-dimensional states: Gridworld's 25
+	// inputs with dOrder 2 would need 8.5e11. When the block has more than coupledTermBudget terms (or its size does not even fit in
+	// 64 bits), init keeps a subset of coupledTermBudget of them. The constant term and the single-input terms cos(pi*m*x[k]),
+	// m <= dOrder, are always kept, and the rest are drawn uniformly without repetition, with a fixed seed so that every basis built
+	// with the same arguments gets the same terms. The kept terms stay in the order of the full block. The budget is raised to
+	// 1 + inputDimension*dOrder if it is smaller. The init above uses defaultCoupledTermBudget, so every block of up to that many
+	// terms is kept whole, as before.
+	void init(const int & inputDimension, int iOrder, int dOrder, const int & coupledTermBudget);
+	static const int defaultCoupledTermBudget = 4096;
+
+	// (dOrder+1)^inputDimension, the size of the full coupled block, or -1 if it does not fit in a long long.
+	static long long countCoupledTerms(const int & inputDimension, const int & dOrder);
+
+	// Did init keep only a subset of the coupled block?
+	bool isCoupledBlockSubsampled() const;
 	int getNumOutputs() const;
+	int getInputDimension() const;
 	std::vector<double> basify(const std::vector<double> & x) const;
 
+	// Same as above, but writes phi(x) into result (resized to getNumOutputs()) so the caller can reuse the buffer between calls.
+	void basify(const std::vector<double> & x, std::vector<double> & result) const;
+
+	// phi(x) for a sparse state x, stored as the terms that x touches and their difference from 1 (see SparseState.hpp). Only the
+	// columns of C of the nonzero inputs are visited, so the cost is proportional to the number of coefficients on those inputs,
+	// not to getNumOutputs(): for a one-hot state and dOrder 0, it is the iOrder terms of one input. The features are the ones
+	// basify gives for the dense state (the cosines are evaluated directly, even when the harmonic recurrence is on). The Implicit
+	// layout has no columns, so it evaluates every term (from a dense copy of x, made on every call). result keeps its buffers between calls, so it can be reused for every step.
+	void basify(const SparseState & x, SparseFeatures & result) const;
+
+	// phi of numStates states at once. states is row-major numStates x inputDimension (state n at states[n*inputDimension]), and
+	// features is row-major numStates x getNumOutputs(). The arguments are computed tile by tile (a block of terms for a group of
+	// states, so each block of coefficients is loaded once per group and stays in cache for the whole chunk of states), followed
+	// by the cosine pass over the tile. Chunks of states are run in parallel with OpenMP when there are at least minParallelBatch
+	// states. The values are bit-identical to calling basify on each state.
+	void basifyBatch(const double * states, const int & numStates, double * features) const;
+
+	// Same as above, with states.size() / inputDimension states. features is resized to fit.
+	void basifyBatch(const std::vector<double> & states, std::vector<double> & features) const;
+
+	// Choose how the cosines are evaluated (see VectorMath.hpp). The default, CosineMode::Exact, reproduces the original features bit-for-bit.
+	void setCosineMode(const CosineMode & mode);
+	CosineMode getCosineMode() const;
+
+	// out[i] = c_i.x for every term i, so that phi(x)[i] = cos(pi*out[i]). These are the arguments basify takes the cosines of.
+	void getArguments(const double * x, double * out) const;
+
+	// C in compressed sparse columns: the nonzeros of input k are (columnTerm[e], columnCoefficient[e]) for
+	// e = columnStart[k]..columnStart[k+1]-1, in increasing order of term. Works with every layout. See IncrementalFeatures.hpp.
+	void getCoefficientColumns(std::vector<int> & columnStart, std::vector<int> & columnTerm, std::vector<int> & columnCoefficient) const;
+
+	// The independent terms of input k are the harmonics cos(pi*j*x[k]), j = dOrder+1..iOrder. When enabled, basify generates them
+	// with the Chebyshev recurrence cos((j+1)a) = 2cos(a)cos(ja) - cos((j-1)a), so each input costs one cosine instead of one per
+	// order (none when dOrder >= 1, as cos(pi*m*x[k]) for m <= dOrder are already dependent terms). The recurrence is restarted
+	// from directly evaluated cosines every maxRecurrenceSteps steps, which keeps the features within ~1e-14 of direct evaluation up
+	// to iOrder 10 (2e-13 at iOrder 40). Off by default, since the result is not bit-identical to evaluating every cosine.
+	void setHarmonicRecurrence(const bool & enabled);
+
+	// Number of cosines one call to basify evaluates with the current settings.
+	int getNumCosineEvaluations() const;
+
+	// Store C densely (column-major, so C*x is a few long vectorized loops) or sparsely (compressed rows of (input index, integer
+	// coefficient), so c_i.x only touches the nonzeros). Both give bit-identical features. init picks Sparse when at most a
+	// 1/sparseDensity fraction of C is nonzero, which is the case for the independent terms and for high-dimensional states.
+	// Implicit stores no coefficients at all: the coupled terms are enumerated in the order init builds them (a counter in base
+	// dOrder+1, input 0 the fastest digit) while the arguments are computed, and each c_i.x is updated from the previous one, since
+	// consecutive counters differ in one digit (plus the digits that wrap to zero). This takes O(inputDimension) memory and O(1)
+	// amortized work per term. The sums are kept from the last input down, so terms with three or more nonzero coefficients can
+	// differ from the other layouts in the last bit of the argument. Implicit needs the whole coupled block and at most
+	// maxImplicitInputs inputs (if dOrder > 0), and throws std::invalid_argument otherwise. init never picks it: set it after init
+	// when C is too large to store. Switching from Implicit back to Dense or Sparse rebuilds C.
+	void setCoefficientLayout(const CoefficientLayout & layout);
+	CoefficientLayout getCoefficientLayout() const;
+
+	// Can setCoefficientLayout(CoefficientLayout::Implicit) be used with this basis?
+	bool supportsImplicitLayout() const;
+
+	// Number of nonzero entries of C (counted rather than stored when the layout is Implicit).
+	long long getNumNonzeros() const;
+
+	// Bytes held by the coefficients in the current layout.
+	size_t getCoefficientMemory() const;
+
+	// Bytes of the whole basis: the object and its coefficients.
+	size_t getMemory() const;
+
+	static const int maxImplicitInputs = 64;
+
 private:
+	// Write the arguments c_i.x of terms i = begin..end-1 into out[0..end-begin-1].
+	void computeArguments(const double * x, const int & begin, const int & end, double * out) const;
+
+	// Call visitor(i, k, coefficient) for every nonzero of C, in increasing order of term i, then of input k.
+	template <typename Visitor>
+	void forEachNonzero(Visitor && visitor) const;
+
+	// computeArguments for the Implicit layout.
+	void computeImplicitArguments(const double * x, const int & begin, const int & end, double * out) const;
+
+	// Build C as compressed sparse rows: the coupled terms (the given counters if the block is subsampled, every counter otherwise),
+	// then the independent ones.
+	void buildRows(const std::vector<std::vector<int>> & sampled);
+
+	// basifyBatch for states first..last-1, on the calling thread.
+	void basifyChunk(const double * states, const int & first, const int & last, double * features) const;
+
+	// computeArguments for count consecutive states (row-major in x), writing state m's arguments to out + m*outStride.
+	void computeArgumentsGroup(const double * x, const int & count, const int & begin, const int & end, double * out, const int & outStride) const;
+
+	// The coupled terms kept when the block is subsampled, as counters (coefficient vectors), in the order of the full block.
+	static std::vector<std::vector<int>> sampleCoupledTerms(const int & inputDimension, const int & dOrder, const int & budget);
+
+	// Write the independent terms into out (indexed like the full feature vector, with the dependent terms already filled in)
+	// using the Chebyshev recurrence.
+	void evaluateHarmonics(const double * x, double * out) const;
+
+	// cos(pi*x[k]), taken from the dependent block if it has it. dependent may be nullptr.
+	double harmonicBase(const double * x, const int & k, const double * dependent) const;
+
+	// Write the count (<= maxRecurrenceSteps) independent terms of input k with orders firstHarmonic+n0, ... into h[0..count-1],
+	// restarting the recurrence at n0. Seeds are read from dependent (the dependent block) when it is not nullptr.
+	void evaluateHarmonicRun(const double * x, const int & k, const int & n0, const int & count, const double & cosA, const double * dependent, double * h) const;
+
+	// cos(pi*m*a) for input a = x[k]: free for m in {0,1} and, when dependent is provided, for m <= dOrder; a direct cosine otherwise.
+	double harmonic(const double & a, int m, const double & cosA, const int & unit, const double * dependent) const;
+
+	// cos(pi*t) for a single t, in the current cosine mode.
+	double cosPiOne(const double & t) const;
+
 	int nTerms;							// Total number of outputs
 	int inputDimension;
-	std::vector<std::vector<double>> c;	// Coefficients
-};
\ No newline at end of file
+	int stride;							// Length of one column of c: nTerms, rounded up so that every column starts on an aligned address
+	int firstIndependent;				// Index of the first independent term. The independent terms of input k are at firstIndependent + k*numHarmonics + (j - firstHarmonic)
+	int firstHarmonic;					// Lowest order j of an independent term (dOrder+1)
+	int numHarmonics;					// Number of independent terms per input (iOrder-dOrder, or zero)
+	bool coupledSubsampled;				// The dependent block is a subset (see init). Its terms are then not at the positions the recurrence seeds are read from.
+
+	// Coefficients, stored column-major: c[k*stride + i] is the coefficient of input k in term i. This makes C*x a sequence
+	// of inputDimension contiguous multiply-adds over all of the terms, which the compiler can vectorize. Empty unless layout == Dense.
+	AlignedVector c;
+
+	// Coefficients in compressed sparse rows: the nonzeros of term i are (termIndex[e], termCoefficient[e]) for e = rowStart[i]..rowStart[i+1]-1,
+	// sorted by input index. Built by init; it is the definition of C that the dense copy is made from. Empty when layout == Implicit.
+	std::vector<int> rowStart, termIndex, termCoefficient;
+
+	// The same nonzeros in compressed sparse columns (see getCoefficientColumns), for sparse states. Empty when layout == Implicit.
+	std::vector<int> columnStart, columnTerm, columnCoefficient;
+
+	CoefficientLayout layout = CoefficientLayout::Dense;
+	static const int sparseDensity = 2;	// Use the sparse layout when nonzeros * sparseDensity <= nTerms * inputDimension
+
+	CosineMode cosineMode = CosineMode::Exact;
+	bool harmonicRecurrence = false;
+	static const unsigned long long coupledSampleSeed = 0x5eed;	// Seed of the generator that picks the kept coupled terms
+	static const int maxRecurrenceSteps = 10;	// Recurrence steps between two restarts from directly evaluated cosines
+	static const int batchTermBlock = 512;		// basifyBatch: terms per tile (the tile's outputs and coefficients fit in L1/L2)
+	static const int batchGroupSize = 4;		// basifyBatch: states whose arguments are computed together, sharing each coefficient load
+	static const int batchChunkSize = 64;		// basifyBatch: states per parallel work item
+	static const int minParallelBatch = 512;	// basifyBatch: smallest batch that is split across threads
+};
+
+template <typename Visitor>
+void FourierBasis::forEachNonzero(Visitor && visitor) const {
+	if (layout != CoefficientLayout::Implicit) {
+		for (int i = 0; i < nTerms; i++)
+			for (int e = rowStart[i]; e < rowStart[i + 1]; e++)
+				visitor(i, termIndex[e], termCoefficient[e]);
+		return;
+	}
+	std::vector<int> digit(inputDimension, 0);		// The counter of coupled term i, as in computeImplicitArguments
+	for (int i = 0; i < firstIndependent; i++) {
+		for (int k = 0; k < inputDimension; k++)
+			if (digit[k] != 0)
+				visitor(i, k, digit[k]);
+		for (int k = 0; (k < inputDimension) && (++digit[k] == firstHarmonic); k++)
+			digit[k] = 0;
+	}
+	for (int i = firstIndependent; i < nTerms; i++) {
+		const int t = i - firstIndependent;
+		visitor(i, t / numHarmonics, firstHarmonic + t % numHarmonics);
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "stdafx.h"
+
+/*
+The layout of a Gridworld: a width x height grid of cells, some of them walls, with a start cell and a goal cell. Cell (x, y) has
+id x + y*width, with (0,0) at the bottom left. It is built once and then shared, read-only, by every copy of the Gridworld (one per
+trial in runExperiment), so that large maps are held once: a 10000 x 10000 map takes 62.5 MB.
+
+The walls are a bitset (one bit per cell). The moves are precomputed from them into a transition table with four bits per cell,
+bit a set when action a leaves the cell (the target is inside the grid and not a wall), so a step is one table lookup and no
+bounds or wall checks. Actions are 0: up (y+1), 1: down (y-1), 2: left (x-1), 3: right (x+1), as in Gridworld::update.
+
+Maps can be loaded from a file (see load), in either of two formats:
+	Text:	one line per row, the top row (y = height-1) first. '#' is a wall, '.' or ' ' a free cell, 'S' the start and 'G' the goal
+			(both free). Every row must have the same length. Without 'S' or 'G', the start is (0,0) and the goal (width-1,height-1).
+	Binary:	the 8 bytes "GRIDMAP1", then width, height, start and goal cell ids as 32-bit integers, then the wall bitset, bit i of
+			64-bit word i/64 (in the byte order of the machine) for cell i. Written by saveBinary.
+*/
+class GridMap {
+public:
+	// A width x height map with no walls, its start at (0,0) and its goal at (width-1,height-1).
+	GridMap(const int & width, const int & height);
+
+	// Load a map from path, in the text or the binary format (the binary one is recognized by its first 8 bytes). Throws
+	// std::runtime_error if the file cannot be read, and std::invalid_argument if it is not a valid map.
+	static GridMap load(const std::string & path);
+
+	// Write the map to path in the binary format. Throws std::runtime_error if the file cannot be written.
+	void saveBinary(const std::string & path) const;
+
+	// A width x height map where each cell is a wall with probability wallFraction, drawn with the given seed. The bottom row and
+	// the right column are kept free, so the goal (the top-right cell) can always be reached from the start (the bottom-left cell).
+	static GridMap random(const int & width, const int & height, const double & wallFraction, const unsigned long long & seed);
+
+	// Change the map. The transition table is updated around the cell. The start and the goal cannot be walls.
+	void setWall(const int & x, const int & y, const bool & wall);
+	void setStart(const int & x, const int & y);
+	void setGoal(const int & x, const int & y);
+
+	int getWidth() const;
+	int getHeight() const;
+	int getNumCells() const;
+	bool isWall(const int & x, const int & y) const;
+
+	// Ids of the start and goal cells.
+	int getStart() const;
+	int getGoal() const;
+
+	// The cell that action takes cell to: its neighbor in that direction, or cell itself if the move is blocked.
+	int move(const int & cell, const int & action) const {
+		const int allowed = (moves[cell >> 1] >> ((cell & 1) << 2)) & 0xF;
+		return ((allowed >> action) & 1) ? cell + offset[action] : cell;
+	}
+
+	// Bytes held by the map: the object, the wall bitset and the transition table.
+	size_t getMemory() const;
+
+private:
+	// Recompute the transition table entry of cell (x, y).
+	void updateMoves(const int & x, const int & y);
+
+	// Check that (x, y) is in the grid, throwing std::out_of_range otherwise.
+	void checkCell(const int & x, const int & y) const;
+
+	static GridMap loadText(std::istream & in);
+	static GridMap loadBinary(std::istream & in);
+
+	int width, height;
+	int start, goal;
+	int offset[4];						// Change of the cell id for each action
+	std::vector<unsigned long long> walls;	// Bit i of walls[i/64] is set if cell i is a wall
+	std::vector<unsigned char> moves;		// The allowed actions of cell i in bits 4*(i%2)..4*(i%2)+3 of moves[i/2]
+};
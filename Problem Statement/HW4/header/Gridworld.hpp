@@ -5,14 +5,28 @@
 // A "Gridworld" object is an environment that the agent can interact with.
 class Gridworld {
 public:	// This means that code outside of this class can see and reference the following functions.
-	// This is the "constructor". This function is called whenever a Gridworld object is created.
+	// The type of state that runExperiment gets from getState and passes to the agent. The Gridworld state is one-hot, so it is
+	// passed as a SparseState, and the agents only do work for its single nonzero. The other environments use std::vector<double>.
+	typedef SparseState Observation;
+
+	// This is the "constructor". This function is called whenever a Gridworld object is created. It makes the original 5x5 grid
+	// with no walls, starting at (0,0) and ending at (4,4).
 	Gridworld();
 
+	// A Gridworld on the given map (see GridMap.hpp), e.g. one loaded from a file with GridMap::load. The map is shared, not copied,
+	// by the copies of this Gridworld, so it is held once however many trials run on it.
+	explicit Gridworld(const std::shared_ptr<const GridMap> & map);
+
+	const GridMap & getMap() const;
+
 	// Below is a function. If X is a Gridworld object, you would call this function with X.getStateDim(). The "const" after
 	// the function says that this function will not change any of the member variables (variables associated with this object, defined below).
 	// This particular function returns the dimension of the state (which is passed as a vector).
 	int getStateDim() const;
 
+	// The number of states (cells), for the tabular agents.
+	int getNumStates() const;
+
 	// The the number of discrete actions.
 	int getNumActions() const;
 
@@ -28,6 +42,15 @@ public:	// This means that code outside of this class can see and reference the
 	// all elements in the interval [0,1] (roughly) **********
 	std::vector<double> getState(std::mt19937_64 & generator);
 
+	// Same as above, but writes the state into result (resized if needed), so that the caller can reuse one buffer for every step.
+	void getState(std::mt19937_64 & generator, std::vector<double> & result);
+
+	// The same state as a SparseState, with the single nonzero: the cost does not depend on the size of the grid.
+	void getState(std::mt19937_64 & generator, SparseState & result);
+
+	// The id of the state, in 0..getNumStates()-1: the index of the nonzero of the states above. The tabular agents take this.
+	void getState(std::mt19937_64 & generator, int & result);
+
 	// A function that returns true if the current state is terminal.
 	bool inTerminalState() const;
 
@@ -36,6 +59,6 @@ public:	// This means that code outside of this class can see and reference the
 	void newEpisode(std::mt19937_64 & generator);
 
 private:	// This means that the objects below are not visible to code outside of this class.
-	const int size = 5;	// This is the size of the gridworld - it is a 5x5 grid.
-	int x, y;			// Agent position. This will be converted into the state.
+	std::shared_ptr<const GridMap> map;	// The grid, its walls, the start and the goal
+	int cell;							// Agent position, as the id x + y*width of its cell. This is the state.
 };
\ No newline at end of file
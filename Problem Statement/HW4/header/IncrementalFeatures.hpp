@@ -0,0 +1,78 @@
+#pragma once
+
+#include "stdafx.h"
+
+/*
+phi(x) of a FourierBasis for a sequence of states that each differ from the previous one in a few inputs, as in Gridworld (where
+two inputs of the one-hot observation change per step), updated from the previous features instead of recomputed.
+
+Each feature is cos(pi*c_i.x). Along with it we keep sin(pi*c_i.x), so that when input k moves by dx, the terms with a nonzero
+coefficient m in column k of C are rotated by the angle pi*m*dx with the angle-addition formulas:
+	cos(a + b) = cos(a)cos(b) - sin(a)sin(b),	sin(a + b) = sin(a)cos(b) + cos(a)sin(b).
+That takes 2*M cosines for the input (b for each coefficient m <= M in the column) and four multiplies per nonzero, so the cost of a
+step is proportional to the number of nonzeros of C in the changed columns, and the terms that do not involve a changed input are
+not touched at all. Inputs that are bit-for-bit unchanged are skipped.
+
+Every rotation adds a rounding error of a few ulps, so the features are recomputed from scratch every refreshInterval updates,
+which bounds the drift (about 1e-15 per update). They are also recomputed when rotating would cost more than evaluating the
+nTerms cosines again, counting a cosine as rotationsPerCosine rotations: when many inputs change, or when the changed columns
+hold mostly independent terms, as with dOrder 0 on a continuous state. Such a step is then FourierBasis::basify itself (with its
+harmonic recurrence and coefficient layouts), without the sines, so that it costs the same as basify; the sines are only computed
+again, by a recompute, when rotating becomes worthwhile. A recompute gives cos(pi*c_i.x) for the basis's arguments and cosine mode,
+which is what basify returns with the harmonic recurrence off.
+*/
+class IncrementalFeatures {
+public:
+	// Nothing to update. Use reset before use.
+	IncrementalFeatures();
+
+	// Features of basis, which is shared (a copy of this object shares it too).
+	explicit IncrementalFeatures(const std::shared_ptr<const FourierBasis> & basis);
+	void reset(const std::shared_ptr<const FourierBasis> & basis);
+
+	// Make x (of length basis->getInputDimension()) the current state and return phi(x), updated from the features of the previous
+	// state when that is cheaper. The reference stays valid until the next call to update or reset.
+	const std::vector<double> & update(const std::vector<double> & x);
+
+	// phi of the current state.
+	const std::vector<double> & getFeatures() const;
+
+	// Recompute the features from scratch at the next update.
+	void invalidate();
+
+	// Number of incremental updates between two recomputes (at least 1).
+	void setRefreshInterval(const int & interval);
+
+	// How many calls to update rotated the features, and how many recomputed them.
+	long long getNumIncrementalUpdates() const;
+	long long getNumFullUpdates() const;
+
+	static const int defaultRefreshInterval = 64;
+	static const int rotationsPerCosine = 4;
+
+private:
+	// Compute the features of x from scratch, and their sines if withSines.
+	void recompute(const double * x, const bool & withSines);
+
+	// Rotate the terms in column k by the angles pi*m*dx.
+	void rotateColumn(const int & k, const double & dx);
+
+	std::shared_ptr<const FourierBasis> basis;
+	int inputDimension, nTerms;
+
+	// C in compressed sparse columns (see FourierBasis::getCoefficientColumns), and the largest coefficient of each column.
+	std::vector<int> columnStart, columnTerm, columnCoefficient, columnMaxCoefficient;
+
+	std::vector<double> state;		// The current state
+	std::vector<double> features;	// cos(pi*c_i.x)
+	std::vector<double> sines;		// sin(pi*c_i.x)
+	std::vector<double> scratch;	// Arguments during a recompute, and the angles of a rotation
+	std::vector<double> rotationCos, rotationSin;	// cos(pi*m*dx) and sin(pi*m*dx) for m = 0..M
+	std::vector<int> changed;		// Inputs that differ from the current state during an update
+
+	bool valid = false;
+	bool sinesValid = false;		// sines holds the sines of the current features (they are skipped by some recomputes)
+	int updatesSinceRefresh = 0;
+	int refreshInterval = defaultRefreshInterval;
+	long long numIncrementalUpdates = 0, numFullUpdates = 0;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "stdafx.h"
+
+// phi(s) for each of numLanes lanes (see LockstepQLearning.hpp), row-major numLanes x numFeatures. basify computes the rows of a
+// set of lanes with one call to FourierBasis::basifyBatch, gathering their states together and scattering the features back when
+// only some of the lanes are set. The rows are bit-identical to FourierBasis::basify on each state.
+class LaneFeatures {
+public:
+	// Empty. Use resize before use.
+	LaneFeatures();
+
+	void resize(const int & numLanes, const int & numFeatures);
+
+	// Row k = phi(state of lane k) for each lane k where lanes[k] is nonzero. states is row-major numLanes x fb.getInputDimension(),
+	// the layout of the batched environments' getStates. The other rows are not changed.
+	void basify(const FourierBasis & fb, const double * states, const unsigned char * lanes);
+
+	// phi of lane k.
+	double * lane(const int & k);
+	const double * lane(const int & k) const;
+
+	void swap(LaneFeatures & other);
+
+	// Bytes held by the buffers.
+	size_t getMemory() const;
+
+private:
+	int numLanes, numFeatures;
+	AlignedVector features;
+	std::vector<double> gatheredStates;		// The states of the lanes being basified, when not all of them are
+	AlignedVector gatheredFeatures;			// and their features
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "stdafx.h"
+
+/*
+numLanes independent QLearning agents advanced together, for runLockstepTrials (see LockstepRunner.hpp), which runs one trial in
+each lane. The lanes share the FourierBasis; the weights of all of them are one WeightMatrix with numLanes*numActions rows (row
+k*numActions + a is w[a] of lane k), and phi of the current and next state of every lane is computed with one batched basify per
+step (see LaneFeatures.hpp). The functions take masks of numLanes bytes (nonzero for true), and only touch the lanes that are set,
+so lanes whose trial has finished, or that wait for the others, are left alone.
+The lanes can also hold different configurations, one alpha and epsilon each, trained side by side on their own trajectories by
+runLockstepSweep (see LockstepRunner.hpp): a grid search over alpha and epsilon then runs as one lockstep agent per trial.
+Each lane does exactly what a QLearning with the same arguments does, in the same order, with the same kernels and its own random
+number generator, so it gives bit-identical results.
+*/
+class LockstepQLearning {
+public:
+	// numLanes agents, each constructed as QLearning(stateDim, numActions, alpha, gamma, epsilon, iOrder, dOrder, coupledTermBudget).
+	LockstepQLearning(const int & numLanes, const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & iOrder, const int & dOrder, const int & coupledTermBudget = FourierBasis::defaultCoupledTermBudget);
+
+	// One lane per configuration: lane k is QLearning(stateDim, numActions, alphas[k], gamma, epsilons[k], iOrder, dOrder,
+	// coupledTermBudget). The configurations share the basis, so they must share iOrder and dOrder (see runLockstepSweep).
+	LockstepQLearning(const int & stateDim, const int & numActions, const std::vector<double> & alphas, const double & gamma, const std::vector<double> & epsilons, const int & iOrder, const int & dOrder, const int & coupledTermBudget = FourierBasis::defaultCoupledTermBudget);
+
+	int getNumLanes() const;
+
+	// Start an episode in each lane set in lanes, whose first state is in states (row-major numLanes x stateDim).
+	void newEpisode(const unsigned char * lanes, const double * states);
+
+	// For each lane set in active, the action QLearning::getAction takes in the lane's current state, drawn with generators[k].
+	void getActions(const unsigned char * active, std::mt19937_64 * generators, int * actions);
+
+	// The update of QLearning::train in each lane set in active, from the lane's current state, actions[k], rewards[k], and the next
+	// state (row k of nextStates), which is terminal if terminal[k] is nonzero. The next state becomes the current state.
+	void train(const unsigned char * active, const int * actions, const double * rewards, const double * nextStates, const unsigned char * terminal);
+
+	// q(s,a) of lane k for its current state, for checks.
+	double getQ(const int & k, const int & a) const;
+
+	// Bytes held by each copy (the weights and the features of every lane), and shared by all copies (the basis).
+	size_t getTrialMemory() const;
+	size_t getSharedMemory() const;
+
+private:
+	std::shared_ptr<const FourierBasis> fb;
+	int numLanes, numFeatures, numActions;
+	std::vector<double> alphas;				// The step size of each lane
+	double gamma;
+	WeightMatrix w;							// Row k*numActions + a: w[a] of lane k
+	LaneFeatures phi, phiNext;				// phi(s) and phi(s') of every lane
+	std::vector<unsigned char> nonterminal;	// During train: the lanes whose s' is needed
+	std::vector<QValues> laneQ;				// q(s,.) of each lane, computed by train when s was s' and used by getActions
+	std::vector<unsigned char> qReady;		// The lanes whose laneQ is up to date
+	std::vector<std::bernoulli_distribution> d1;	// Exploration of each lane, with its epsilon
+	std::uniform_int_distribution<int> d2;
+};
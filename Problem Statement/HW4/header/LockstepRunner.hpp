@@ -0,0 +1,97 @@
+#pragma once
+
+#include "stdafx.h"
+
+// One copy of a lockstep agent (LockstepQLearning or LockstepSarsa) and of a batched environment (e.g. BatchedMountainCar) with the
+// same number of lanes, run to the end of a trial in every lane, all lanes advancing one step per iteration of the loop: the actions
+// of every lane, one batched environment update, one batched basify and the TD updates of every lane. Lane k draws from a generator
+// seeded with seeds[k], and adds the discounted return of each of its numEpisodes episodes to laneReturns[k][episode] (nullptr for
+// a lane without a trial, which is left idle). A lane whose episode ends starts the next one on its own (through the reset masks),
+// and leaves the loop when it has run numEpisodes, so lanes need not be at the same episode. Each lane does what runExperiment does
+// for one trial, so its returns are bit-identical to those of that trial.
+template <typename LockstepAgent, typename BatchedEnvironment>
+void runLockstepLanes(LockstepAgent & agent, BatchedEnvironment & environment, const std::vector<unsigned long long> & seeds, const int & numEpisodes, const int & maxEpisodeLength, const double & gamma, const std::vector<double *> & laneReturns) {
+	const int numLanes = agent.getNumLanes(), stateDim = environment.getStateDim();
+	std::vector<std::mt19937_64> generators(numLanes);
+	std::vector<unsigned char> active(numLanes), reset(numLanes);
+	std::vector<int> episode(numLanes, 0), t(numLanes, 0), actions(numLanes, 0);
+	std::vector<double> curGamma(numLanes, 1.0), rewards(numLanes), states((size_t)numLanes * stateDim), nextStates((size_t)numLanes * stateDim);
+	for (int k = 0; k < numLanes; k++) {
+		generators[k].seed(seeds[k]);
+		active[k] = (laneReturns[k] != nullptr) && (numEpisodes > 0);
+	}
+	environment.newEpisode(active.data());
+	environment.getStates(states.data());
+	agent.newEpisode(active.data(), states.data());
+	while (std::find(active.begin(), active.end(), 1) != active.end()) {
+		agent.getActions(active.data(), generators.data(), actions.data());
+		environment.update(actions.data(), active.data(), rewards.data());
+		environment.getStates(nextStates.data());
+		const unsigned char * terminal = environment.getTerminalMask();
+		agent.train(active.data(), actions.data(), rewards.data(), nextStates.data(), terminal);
+		for (int k = 0; k < numLanes; k++) {
+			reset[k] = 0;
+			if (!active[k])
+				continue;
+			laneReturns[k][episode[k]] += curGamma[k] * rewards[k];
+			curGamma[k] *= gamma;
+			if (terminal[k] || (++t[k] >= maxEpisodeLength)) {	// The episode is over
+				t[k] = 0;
+				curGamma[k] = 1.0;
+				reset[k] = (++episode[k] < numEpisodes);
+				active[k] = reset[k];
+			}
+		}
+		environment.newEpisode(reset.data());
+		environment.getStates(states.data());
+		agent.newEpisode(reset.data(), states.data());
+	}
+}
+
+// The trials of runExperiment (see main.cpp), run a.getNumLanes() at a time in lockstep: each OpenMP iteration takes a group of
+// numLanes trials, with its own copy of the agent a, whose lanes all hold the same configuration, and of the environment e. Trial
+// t uses a generator seeded with t, as in runExperiment, so returns[t][episode] is bit-identical to runExperiment's.
+template <typename LockstepAgent, typename BatchedEnvironment>
+void runLockstepTrials(const LockstepAgent & a, const BatchedEnvironment & e, const int & numTrials, const int & numEpisodes, const int & maxEpisodeLength, const double & gamma, std::vector<std::vector<double>> & returns) {
+	const int numLanes = a.getNumLanes();
+	if (e.getNumLanes() != numLanes)
+		throw std::invalid_argument("runLockstepTrials: the agent and the environment have different numbers of lanes");
+	const int numGroups = (numTrials + numLanes - 1) / numLanes;
+	returns.assign(numTrials, std::vector<double>(numEpisodes, 0.0));
+	std::vector<LockstepAgent> agents(numGroups, a);
+	std::vector<BatchedEnvironment> environments(numGroups, e);
+	#pragma omp parallel for schedule(dynamic)
+	for (int group = 0; group < numGroups; group++) {
+		const int firstTrial = group * numLanes;
+		std::vector<unsigned long long> seeds(numLanes);
+		std::vector<double *> laneReturns(numLanes, nullptr);	// The last group can have lanes without a trial
+		for (int k = 0; k < numLanes; k++) {
+			seeds[k] = firstTrial + k;
+			if (firstTrial + k < numTrials)
+				laneReturns[k] = returns[firstTrial + k].data();
+		}
+		runLockstepLanes(agents[group], environments[group], seeds, numEpisodes, maxEpisodeLength, gamma, laneReturns);
+	}
+}
+
+// A sweep over configurations: lane c of a (built with one alpha and epsilon per lane, see LockstepQLearning) is configuration c, and
+// each OpenMP iteration runs one trial of every configuration in lockstep, all lanes with generators seeded with the trial. So
+// returns[c][t][episode] is bit-identical to runExperiment's returns of trial t for an agent with configuration c, and a grid search
+// over alpha and epsilon for one iOrder and dOrder runs as numTrials lockstep runs instead of numConfigs*numTrials scalar ones.
+template <typename LockstepAgent, typename BatchedEnvironment>
+void runLockstepSweep(const LockstepAgent & a, const BatchedEnvironment & e, const int & numTrials, const int & numEpisodes, const int & maxEpisodeLength, const double & gamma, std::vector<std::vector<std::vector<double>>> & returns) {
+	const int numConfigs = a.getNumLanes();
+	if (e.getNumLanes() != numConfigs)
+		throw std::invalid_argument("runLockstepSweep: the agent and the environment have different numbers of lanes");
+	returns.assign(numConfigs, std::vector<std::vector<double>>(numTrials, std::vector<double>(numEpisodes, 0.0)));
+	std::vector<LockstepAgent> agents(numTrials, a);
+	std::vector<BatchedEnvironment> environments(numTrials, e);
+	#pragma omp parallel for schedule(dynamic)
+	for (int trial = 0; trial < numTrials; trial++) {
+		std::vector<unsigned long long> seeds(numConfigs, (unsigned long long)trial);
+		std::vector<double *> laneReturns(numConfigs);
+		for (int c = 0; c < numConfigs; c++)
+			laneReturns[c] = returns[c][trial].data();
+		runLockstepLanes(agents[trial], environments[trial], seeds, numEpisodes, maxEpisodeLength, gamma, laneReturns);
+	}
+}
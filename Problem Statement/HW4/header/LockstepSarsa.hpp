@@ -0,0 +1,44 @@
+#pragma once
+
+#include "stdafx.h"
+
+/*
+numLanes independent Sarsa agents advanced together: to Sarsa what LockstepQLearning is to QLearning (see LockstepQLearning.hpp).
+Each lane gives bit-identical results to a Sarsa with the same arguments and generator.
+*/
+class LockstepSarsa {
+public:
+	LockstepSarsa(const int & numLanes, const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & iOrder, const int & dOrder, const int & coupledTermBudget = FourierBasis::defaultCoupledTermBudget);
+	LockstepSarsa(const int & stateDim, const int & numActions, const std::vector<double> & alphas, const double & gamma, const std::vector<double> & epsilons, const int & iOrder, const int & dOrder, const int & coupledTermBudget = FourierBasis::defaultCoupledTermBudget);
+
+	int getNumLanes() const;
+	void newEpisode(const unsigned char * lanes, const double * states);
+	void getActions(const unsigned char * active, std::mt19937_64 * generators, int * actions);
+	void train(const unsigned char * active, const int * actions, const double * rewards, const double * nextStates, const unsigned char * terminal);
+
+	// q(s,a) of lane k for its current state, for checks.
+	double getQ(const int & k, const int & a) const;
+
+	size_t getTrialMemory() const;
+	size_t getSharedMemory() const;
+
+private:
+	// Compute laneQ[k] = q(s,.) of lane k, unless it is up to date.
+	void loadQ(const int & k);
+
+	std::shared_ptr<const FourierBasis> fb;
+	int numLanes, numFeatures, numActions;
+	std::vector<double> alphas;
+	double gamma;
+	WeightMatrix w;							// Row k*numActions + a: w[a] of lane k
+	LaneFeatures phi_s, phi, phiNext;		// phi of the previous, the current and the next state of every lane
+	std::vector<unsigned char> nonterminal;	// During train: the lanes whose s' is needed
+	std::vector<QValues> laneQ;				// q(s,.) of each lane, shared by getActions and train as Sarsa's StepCache does
+	std::vector<unsigned char> qReady;		// The lanes whose laneQ is up to date
+	std::vector<std::bernoulli_distribution> d1;
+	std::uniform_int_distribution<int> d2;
+
+	std::vector<unsigned char> flag;
+	std::vector<int> previous_a;
+	std::vector<double> previous_r;
+};
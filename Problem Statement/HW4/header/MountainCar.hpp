@@ -5,19 +5,30 @@
 // MountainCar MDP - see Gridworld.hpp for comments regarding the general structure of these environment/MDP objects
 class MountainCar {
 public:
+	// The shape is fixed, so the state can be a std::array: the static agents take it directly (see ObservationType.hpp). The
+	// other agents take the std::vector<double> Observation, which getState also writes.
+	static constexpr int stateDim = 2;
+	static constexpr int numActions = 3;
+	typedef std::array<double, stateDim> State;
+	typedef std::vector<double> Observation;	// The state type runExperiment uses (see Gridworld.hpp)
 	MountainCar();	
 	int getStateDim() const;
 	int getNumActions() const;
 	double update(const int & action, std::mt19937_64 & generator);
 	std::vector<double> getState(std::mt19937_64 & generator);
+	void getState(std::mt19937_64 & generator, std::vector<double> & result);
+	void getState(std::mt19937_64 & generator, State & result);
 	bool inTerminalState() const;
 	void newEpisode(std::mt19937_64 & generator);
 
 private:
+	// Write the normalized state to result[0..stateDim-1].
+	void writeState(double * result) const;
+
 	const double minX = -1.2;
 	const double maxX = 0.5;
 	const double minXDot = -0.07;
 	const double maxXDot = 0.07;
 
-	std::vector<double> state;	// [2] - x and xDot
+	State state;					// x and xDot (not normalized)
 };
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "stdafx.h"
+
+// The type of state that runExperiment reads from Environment and passes to Agent. It is:
+//	- Agent::Observation when the agent declares one (the tabular agents take state ids, see TabularQLearning.hpp),
+//	- else Environment::State when the agent and the environment both declare it as the same type: the fixed-shape std::array of
+//	  MountainCar, CartPole and Acrobot, taken by the static agents (see StaticQLearning.hpp), so no state is on the heap,
+//	- and Environment::Observation otherwise (a std::vector<double>, or a SparseState for Gridworld).
+// The environment must have a getState(generator, result) for that type.
+template <typename... T>
+struct MakeVoid {
+	typedef void type;
+};
+
+template <typename Agent, typename Environment, typename = void>
+struct FixedObservationType {
+	typedef typename Environment::Observation type;
+};
+
+template <typename Agent, typename Environment>
+struct FixedObservationType<Agent, Environment, typename std::enable_if<std::is_same<typename Agent::State, typename Environment::State>::value>::type> {
+	typedef typename Environment::State type;
+};
+
+template <typename Agent, typename Environment, typename = void>
+struct ObservationType {
+	typedef typename FixedObservationType<Agent, Environment>::type type;
+};
+
+template <typename Agent, typename Environment>
+struct ObservationType<Agent, Environment, typename MakeVoid<typename Agent::Observation>::type> {
+	typedef typename Agent::Observation type;
+};
+
+// The first N elements of the std::vector<double> s as a std::array: how a state from a runtime-sized environment is passed to
+// the fixed-shape code. s must have N elements.
+template <size_t N>
+std::array<double, N> toFixedState(const std::vector<double> & s) {
+	assert(s.size() == N);
+	std::array<double, N> result;
+	std::copy(s.begin(), s.begin() + N, result.begin());
+	return result;
+}
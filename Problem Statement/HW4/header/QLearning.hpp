@@ -10,8 +10,8 @@ class QLearning {
 public:
 	// This is the constructor. It initializes this agent for an MDP with states provided as vectors of length stateDim, numActions discrete actions,
 	// a step size of alpha, discount parameter gamma, epsilon-greedy exploration parameter epsilon, and using the FourierBasis with independent (decoupled) order iOrder,
-	// and dependent (coupled) order dOrder.
-	QLearning(const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & iOrder, const int & dOrder);
+	// and dependent (coupled) order dOrder. At most coupledTermBudget coupled terms are used (see FourierBasis::init).
+	QLearning(const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & iOrder, const int & dOrder, const int & coupledTermBudget = FourierBasis::defaultCoupledTermBudget);
 
 	// Train the agent based on the transition s,a,r,sPrime (with sPrimeTerminal indicating if sPrime is a terminal state, meaning we will never run the update with s = sPrime).
 	void train(std::mt19937_64 & generator, const std::vector<double> & s, const int & a, double & r, const std::vector<double> & sPrime, const bool & sPrimeTerminal);
@@ -22,12 +22,32 @@ public:
 	// As the agent to provide an action given that we are in state s.
 	int getAction(const std::vector<double> & s, std::mt19937_64 & generator);
 
+	// The same two functions for sparse states, such as Gridworld's (see SparseState.hpp). A step then costs time in proportion to the
+	// number of features the nonzeros touch, rather than to the number of features. These keep their own weights, in a
+	// ShiftedWeightMatrix, which start as a copy of the dense ones on the first call: an agent should be given one kind of state
+	// over its lifetime (runExperiment gives it the environment's Observation type).
+	void train(std::mt19937_64 & generator, const SparseState & s, const int & a, double & r, const SparseState & sPrime, const bool & sPrimeTerminal);
+	int getAction(const SparseState & s, std::mt19937_64 & generator);
+
+	// Bytes that each copy of this agent holds on its own (the object, the weights and the buffers), and bytes that all copies share
+	// (the basis). runExperiment reports both.
+	size_t getTrialMemory() const;
+	size_t getSharedMemory() const;
+
+	// Memoize phi(s) in a FeatureCache of up to capacity states, keyed on the exact state, or on the state quantized with the given
+	// cell widths (see FeatureCache.hpp). Call before the agent is copied (each copy then gets its own, empty, cache). With exact
+	// keys the results are unchanged; this pays off when states repeat, as in Gridworld.
+	void enableFeatureCache(const int & capacity, const std::vector<double> & cellSize = std::vector<double>());
+	const FeatureCache & getFeatureCache() const;
+
 private:
 	// This object, once initialized, takes in state-vectors and outputs feature vectors constructed using the Fourier Basis.
-	FourierBasis fb;
+	// It is never changed after the constructor, so copies of the agent (one per trial in runExperiment) share it rather than
+	// each holding their own coefficient table. Only the weights and the buffers below are per copy.
+	std::shared_ptr<const FourierBasis> fb;
 
-	// The weight vector for linear q-approximation. We store it as one vector for each action. So, w[numActions][numFeatures]. q(s,a) = dot product of w[a] with phi(s).
-	std::vector<std::vector<double>> w;
+	// The weight vector for linear q-approximation. We store it as one row for each action, in one aligned buffer (see WeightMatrix.hpp). So, w[numActions][numFeatures]. q(s,a) = dot product of w[a] with phi(s).
+	WeightMatrix w;
 
 	// Properties of the MDP
 	int stateDim, numFeatures, numActions;
@@ -35,16 +55,31 @@ private:
 	// Step size, and the gamma-hyperparameter for the Q-Learning algorithm (may or may not match the one used when reporting results)
 	double alpha, gamma;
 
-	// phi and phiPrime are phi(s) and phi(s'). We store them so that, between calls to train, we don't recompute phi(s) when we computed it as phi(sPrime) at the previous time step.
-	bool phiInit = false;				// Has phi been initialized? False at t=0, true thereafter.
-	std::vector<double> phi, phiPrime;
+	// phi(s) during a call to train. Its buffer is swapped with the cache's, so that, between calls to train, we don't recompute phi(s)
+	// when we computed it as phi(sPrime) at the previous time step, and don't copy it either.
+	std::vector<double> phi;
+
+	// phi and q for the last state we evaluated (usually sPrime of the last call to train, which is s of the next call to getAction).
+	StepCache cache;
+
+	// Memo of phi(s), used when it is enabled.
+	FeatureCache featureCache;
+
+	// The weights, phi(s) and the step cache of the sparse-state functions.
+	ShiftedWeightMatrix sparseW;
+	SparseFeatures sparsePhi;
+	SparseStepCache sparseCache;
+
+	// Copy w into sparseW on the first call of a sparse-state function.
+	void initSparseWeights();
+
+	// phi(s) (into result) and q(s,.) (into cache), from the FeatureCache if it is enabled.
+	void basify(const std::vector<double> & s, std::vector<double> & result);
+	void loadCache(const std::vector<double> & s);
 
 	// A Bernoulli distribution for determining if we should act greedily or uniformly randomly (we use epsilon greedy)
 	std::bernoulli_distribution d1;
 
 	// A uniform distribution over actions for when we choose to explore.
 	std::uniform_int_distribution<int> d2;
-
-	// Compute max_{a} q(s,a). This function takes the features phi(s) rather than s directly.
-	double maxQ(const std::vector<double> & phi) const;
 };
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "stdafx.h"
+
+// A table of action-values q[s][a] for numStates states and numActions actions, in one flat aligned buffer with the actions of a
+// state next to each other: q(s,.) is numActions consecutive doubles (a single cache line for up to 8 actions, when numActions
+// divides 8), so a step of a tabular agent reads and writes one or two lines.
+class QTable {
+public:
+	// An empty table. Use resize before use.
+	QTable();
+
+	// Make this a numStates x numActions table of zeros.
+	void resize(const int & numStates, const int & numActions);
+
+	int getNumStates() const;
+	int getNumActions() const;
+
+	// Pointer to q(s,0), followed by the other actions of s.
+	double * row(const int & s);
+	const double * row(const int & s) const;
+
+	// Always 0: the table is allocated once, by resize. For agents that also take a PagedQTable.
+	long long getNumGrowths() const;
+
+	// Bytes held by the buffer.
+	size_t getMemory() const;
+
+private:
+	int numStates, numActions;
+	AlignedVector data;
+};
+
+// A QTable that only stores the states that have been written to, for environments with too many states for a dense table (a
+// 10000 x 10000 Gridworld would need 3.2 GB per agent). The states are grouped in pages of pageStates consecutive ids, and a page
+// is materialized, with all of its values zero, the first time one of its states is written. A hash directory (open addressing)
+// maps page numbers to their place in one pool of pages, and the last page looked up is remembered, since consecutive steps
+// usually stay in the same page. Reading a state that was never written gives zeros, without materializing it.
+// Memory is proportional to the number of pages visited (plus up to a factor of 2 while the pool and the directory grow by
+// doubling), whatever the number of states. Materializing a page can allocate, so the row pointers stay valid only until the
+// next call to the non-const row; getNumGrowths counts the allocations.
+class PagedQTable {
+public:
+	// An empty table. Use resize before use.
+	PagedQTable();
+
+	// Make this a numStates x numActions table of zeros, with no page materialized.
+	void resize(const int & numStates, const int & numActions);
+
+	int getNumStates() const;
+	int getNumActions() const;
+
+	// Pointer to q(s,0), followed by the other actions of s. The non-const version materializes the page of s. The const version
+	// points to a row of zeros when it is not materialized.
+	double * row(const int & s);
+	const double * row(const int & s) const;
+
+	// Number of pages materialized, and number of times the pool or the directory grew.
+	int getNumPages() const;
+	long long getNumGrowths() const;
+
+	// Bytes held by the pool, the directory and the row of zeros.
+	size_t getMemory() const;
+
+	static const int pageBits = 6;
+	static const int pageStates = 1 << pageBits;
+
+private:
+	// Position of page in the pool, or -1 if it is not materialized.
+	int findPage(const int & page) const;
+
+	// Slot of page in the directory: where it is, or the empty slot where it would go.
+	int directorySlot(const int & page) const;
+
+	// Double the directory and reinsert the pages.
+	void growDirectory();
+
+	int numStates, numActions, pageSize;	// pageSize = pageStates*numActions doubles
+	int numPages;
+	AlignedVector pool;						// Page p at pool[p*pageSize]
+	std::vector<int> directoryPage;			// Page number in each slot, or -1. The size is a power of two.
+	std::vector<int> directoryPosition;		// Position in the pool of the page in each slot
+	std::vector<double> zeros;				// One row of zeros
+	long long numGrowths;
+	mutable int lastPage, lastPosition;		// The last page found, and its position in the pool
+};
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "stdafx.h"
+
+// Kernels for linear action-values q(s,a) = dot(w[a], phi(s)), shared by the QLearning and Sarsa agents.
+
+// Largest number of discrete actions the agents support (all of our MDPs have at most 4).
+const int maxNumActions = 8;
+
+// q(s,a) for every action a. Only the first numActions entries are used.
+typedef std::array<double, maxNumActions> QValues;
+
+// q[a] = dot(w[a], phi) for a = 0..numActions-1, where numActions = w.getNumRows().
+void computeQValues(const std::vector<double> & phi, const WeightMatrix & w, QValues & q);
+
+// max_a q[a] over the first numActions entries.
+double maxQValue(const QValues & q, const int & numActions);
+double maxQValue(const double * q, const int & numActions);
+
+// argmax_a q[a] over the first numActions entries, with ties broken at random. The generator is only used when there is a tie, and
+// is used exactly as the original getAction used it (see the note in QValues.cpp), so results are reproducible against earlier runs.
+// The pointer versions take the q-values from anywhere, such as a row of a QTable.
+int greedyAction(const QValues & q, const int & numActions, std::mt19937_64 & generator);
+int greedyAction(const double * q, const int & numActions, std::mt19937_64 & generator);
+
+// The features and q-values of the last state an agent evaluated. Within a step the agent sees the same state several times (in
+// getAction, in train, and as s' of one step and s of the next); with this cache each state is basified and evaluated only once.
+// The cached q-values are kept equal to dot(w[a], phi) at all times: call refresh after every change to the weights of an action.
+class StepCache {
+public:
+	// Make s the cached state, computing phi(s) and q(s,.) unless s is already cached. Returns true if it was (a hit).
+	bool load(const FourierBasis & fb, const std::vector<double> & s, const WeightMatrix & w);
+
+	// Same as above, taking phi(s) from a FeatureCache.
+	bool load(FeatureCache & features, const std::vector<double> & s, const WeightMatrix & w);
+
+	// Is s the cached state?
+	bool holds(const std::vector<double> & s) const;
+
+	// The weights of action a changed: recompute q[a] from the cached features.
+	void refresh(const WeightMatrix & w, const int & a);
+
+	// Swap the cached features with buffer and forget the cached state. This hands phi over without copying it, and gives the cache
+	// a buffer (usually of the right size already) to basify the next state into.
+	void swapOutPhi(std::vector<double> & buffer);
+
+	// phi and q of the cached state. Only meaningful after a call to load.
+	const std::vector<double> & getPhi() const;
+	const QValues & getQ() const;
+
+	// Bytes held by the state and feature buffers.
+	size_t getMemory() const;
+
+private:
+	bool valid = false;
+	std::vector<double> state, phi;
+	QValues q;
+};
+
+// StepCache for a TileCoding basis: the same contract, holding the indices of the active tiles of the cached state instead of its
+// features.
+class TileStepCache {
+public:
+	bool load(const TileCoding & tc, const std::vector<double> & s, const WeightMatrix & w);
+	bool holds(const std::vector<double> & s) const;
+	void refresh(const WeightMatrix & w, const int & a);
+
+	// Swap the cached active tiles with buffer and forget the cached state (see StepCache::swapOutPhi).
+	void swapOutActive(std::vector<int> & buffer);
+
+	const std::vector<int> & getActive() const;
+	const QValues & getQ() const;
+	size_t getMemory() const;
+
+private:
+	bool valid = false;
+	std::vector<double> state;
+	std::vector<int> active;
+	QValues q;
+};
+
+// StepCache for sparse states (see SparseState.hpp): the same contract, holding the sparse features of the cached state, and
+// q-values from a ShiftedWeightMatrix.
+class SparseStepCache {
+public:
+	bool load(const FourierBasis & fb, const SparseState & s, const ShiftedWeightMatrix & w);
+	bool holds(const SparseState & s) const;
+	void refresh(const ShiftedWeightMatrix & w, const int & a);
+
+	// Swap the cached features with buffer and forget the cached state (see StepCache::swapOutPhi).
+	void swapOutPhi(SparseFeatures & buffer);
+
+	const SparseFeatures & getPhi() const;
+	const QValues & getQ() const;
+	size_t getMemory() const;
+
+private:
+	bool valid = false;
+	SparseState state;
+	SparseFeatures phi;
+	QValues q;
+};
+
+// StepCache for a basis with fixed-size features, Basis::Features (see StaticFourierBasis.hpp). Same contract as StepCache, except
+// that the features are read with getPhi instead of being swapped out: copying a std::array costs the same as swapping one.
+template <typename Basis>
+class FixedStepCache {
+public:
+	typedef typename Basis::Features Features;
+	typedef typename Basis::State State;
+
+	bool load(const Basis & fb, const State & s, const WeightMatrix & w);
+	bool holds(const State & s) const;
+	void refresh(const WeightMatrix & w, const int & a);
+	const Features & getPhi() const;
+	const QValues & getQ() const;
+
+private:
+	bool valid = false;
+	State state;
+	Features phi;
+	QValues q;
+};
+
+template <typename Basis>
+bool FixedStepCache<Basis>::load(const Basis & fb, const State & s, const WeightMatrix & w) {
+	if (holds(s))
+		return true;
+	state = s;
+	fb.basify(s.data(), phi);
+	for (int a = 0; a < w.getNumRows(); a++)
+		q[a] = dotProduct<Basis::numTerms>(w.row(a), phi.data());
+	valid = true;
+	return false;
+}
+
+template <typename Basis>
+bool FixedStepCache<Basis>::holds(const State & s) const {
+	return valid && (state == s);
+}
+
+template <typename Basis>
+void FixedStepCache<Basis>::refresh(const WeightMatrix & w, const int & a) {
+	if (valid)
+		q[a] = dotProduct<Basis::numTerms>(w.row(a), phi.data());
+}
+
+template <typename Basis>
+const typename FixedStepCache<Basis>::Features & FixedStepCache<Basis>::getPhi() const {
+	return phi;
+}
+
+template <typename Basis>
+const QValues & FixedStepCache<Basis>::getQ() const {
+	return q;
+}
@@ -4,14 +4,26 @@
 
 class Sarsa {
 public:
-	Sarsa(const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & iOrder, const int & dOrder);
+	Sarsa(const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & iOrder, const int & dOrder, const int & coupledTermBudget = FourierBasis::defaultCoupledTermBudget);
 	void train(std::mt19937_64 & generator, const std::vector<double> & s, const int & a, double & r, const std::vector<double> & sPrime, const bool & sPrimeTerminal);
 	void newEpisode(std::mt19937_64 & generator);
 	int getAction(const std::vector<double> & s, std::mt19937_64 & generator);
 
+	// The same two functions for sparse states, with their own weights (see QLearning.hpp).
+	void train(std::mt19937_64 & generator, const SparseState & s, const int & a, double & r, const SparseState & sPrime, const bool & sPrimeTerminal);
+	int getAction(const SparseState & s, std::mt19937_64 & generator);
+
+	// Bytes held by each copy of this agent, and by the basis that all copies share (see QLearning.hpp).
+	size_t getTrialMemory() const;
+	size_t getSharedMemory() const;
+
+	// Memoize phi(s) in a FeatureCache (see QLearning.hpp).
+	void enableFeatureCache(const int & capacity, const std::vector<double> & cellSize = std::vector<double>());
+	const FeatureCache & getFeatureCache() const;
+
 private:
-	FourierBasis fb;
-	std::vector<std::vector<double>> w;
+	std::shared_ptr<const FourierBasis> fb;		// Read-only after the constructor, and shared by every copy of this agent
+	WeightMatrix w;
 	int stateDim, numFeatures, numActions;
 	double alpha, gamma;
 	std::bernoulli_distribution d1;
@@ -25,4 +37,18 @@ private:
 	int previous_a;
 	double previous_r;
 
+	// phi and q for the last state we evaluated: getAction(s) fills it, and train(s, ...) reads it.
+	StepCache cache;
+
+	// Memo of phi(s), used when it is enabled, and q(s,.) through it.
+	FeatureCache featureCache;
+	void loadCache(const std::vector<double> & s);
+
+	// The weights, the features of the previous state and the step cache of the sparse-state functions. The flag and the previous
+	// action and reward above are shared with the dense functions.
+	ShiftedWeightMatrix sparseW;
+	SparseFeatures sparse_phi_s;
+	SparseStepCache sparseCache;
+	void initSparseWeights();
+
 };
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "stdafx.h"
+
+// Weights of a linear action-value function for features given as phi = 1 + d with a sparse d (see SparseFeatures), so that
+// q-values and TD updates cost O(number of touched terms) instead of O(numColumns). Row a holds w[a][i] = base[a][i] + shift[a]:
+//	- an update w[a] += scale*phi adds scale to shift[a] (the "1" part) and scale*d_i to base[a][i] for the touched terms i only.
+//	- q(s,a) = dot(w[a], phi) = sum_i base[a][i] + numColumns*shift[a] + sum over the touched terms of w[a][i]*d_i, with the first
+//	  sum kept up to date for every row.
+// The values equal those of WeightMatrix with dense features in exact arithmetic, but are rounded differently. To keep the rounding
+// error of the row sums from building up, each row sum is recomputed from the row every numColumns updates of that row, which
+// adds O(1) amortized work per update.
+class ShiftedWeightMatrix {
+public:
+	// An empty matrix. Use assign before use.
+	ShiftedWeightMatrix();
+
+	// Make this hold the same weights as w.
+	void assign(const WeightMatrix & w);
+
+	// Write the weights into w, which must have the same shape.
+	void copyTo(WeightMatrix & w) const;
+
+	int getNumRows() const;
+	int getNumColumns() const;
+
+	// w[a][i], for checks and for copying out single weights.
+	double get(const int & a, const int & i) const;
+
+	// dot(w[a], phi) and w[a] += scale*phi.
+	double dot(const int & a, const SparseFeatures & phi) const;
+	void addScaled(const int & a, const double & scale, const SparseFeatures & phi);
+
+	// Bytes held by the buffers.
+	size_t getMemory() const;
+
+private:
+	// rowSum[a] = sum_i base[a][i], recomputed from the row.
+	void resum(const int & a);
+
+	WeightMatrix base;
+	std::vector<double> shift, rowSum;
+	std::vector<int> updatesSinceResum;
+};
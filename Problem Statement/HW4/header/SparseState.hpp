@@ -0,0 +1,82 @@
+#pragma once
+
+#include "stdafx.h"
+
+// An observation given by its nonzero elements, as (index, value) pairs in increasing order of index, out of getDimension()
+// elements. Gridworld returns its one-hot states this way (a single pair), so that the basis and the agents can do work in
+// proportion to the number of nonzeros rather than to the number of cells (see FourierBasis::basify and ShiftedWeightMatrix).
+class SparseState {
+public:
+	// A state of dimension zero. Use reset or setOneHot before use.
+	SparseState();
+
+	// The zero state of the given dimension.
+	explicit SparseState(const int & dimension);
+
+	// Make this the zero state of the given dimension. Keeps the buffers, so it does not allocate once they are large enough.
+	void reset(const int & dimension);
+
+	// Make this the state of the given dimension with a single 1 at index.
+	void setOneHot(const int & dimension, const int & index);
+
+	// Append the nonzero (index, value). index must be larger than every index already in the state.
+	void push(const int & index, const double & value);
+
+	int getDimension() const;
+	int getNumNonzeros() const;
+
+	// The indices and values of the nonzeros, getNumNonzeros() of each.
+	const int * getIndices() const;
+	const double * getValues() const;
+
+	// The dense state, with zeros everywhere else (result is resized to getDimension()).
+	void toDense(std::vector<double> & result) const;
+	std::vector<double> toDense() const;
+
+	bool operator==(const SparseState & other) const;
+	bool operator!=(const SparseState & other) const;
+
+	void swap(SparseState & other);
+
+	// Bytes held by the buffers.
+	size_t getMemory() const;
+
+private:
+	int dimension;
+	std::vector<int> indices;
+	std::vector<double> values;
+};
+
+// phi(x) of a SparseState x, stored as its difference from phi(0). Every Fourier feature cos(pi*c_i.x) is 1 at x = 0, and stays 1
+// for every term whose coefficients are zero on the nonzeros of x. So phi(x) = 1 + d, where d is zero outside of the terms that
+// x "touches". Only those terms are stored, with d on them (see FourierBasis::basify(const SparseState &, SparseFeatures &)).
+class SparseFeatures {
+public:
+	// The touched terms, in no particular order, and d on each of them. getNumTerms() of each.
+	int getNumTerms() const;
+	const int * getTerms() const;
+	const double * getDeviations() const;
+
+	// Used by FourierBasis to fill this in: start with no terms, for a basis of numOutputs terms; add value to the argument c_i.x
+	// of term i (the first call for a term adds it to the touched terms); and replace each argument t by cos(pi*t) - 1.
+	void beginArguments(const int & numOutputs);
+	void addArgument(const int & term, const double & value);
+	void endArguments(const CosineMode & mode);
+
+	// The same for a basis that computes every argument from the dense state (FourierBasis with the implicit layout): touch all
+	// numOutputs terms and return their arguments, to be written in place of adding them up, then call endArguments. denseInput
+	// writes x to a buffer kept here. Neither allocates once the buffers are large enough.
+	double * beginAllArguments(const int & numOutputs);
+	const double * denseInput(const SparseState & x);
+
+	void swap(SparseFeatures & other);
+
+	// Bytes held by the buffers.
+	size_t getMemory() const;
+
+private:
+	std::vector<int> terms;
+	std::vector<double> deviations;		// The arguments, until endArguments
+	std::vector<int> slot;				// slot[i] is the position of term i in terms, or -1. All -1 outside of begin/endArguments.
+	std::vector<double> input;			// The dense state, for denseInput
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "stdafx.h"
+
+// ipow, for use in constant expressions.
+constexpr int constexprPow(const int a, const int b) {
+	return (b == 0) ? 1 : a * constexprPow(a, b - 1);
+}
+
+// Number of terms of the Fourier basis of order (iOrder, dOrder) on stateDim inputs: (dOrder+1)^stateDim dependent terms, then
+// iOrder-dOrder independent terms per input.
+constexpr int fourierNumTerms(const int stateDim, const int iOrder, const int dOrder) {
+	return constexprPow(dOrder + 1, stateDim) + stateDim * ((iOrder > dOrder) ? (iOrder - dOrder) : 0);
+}
+
+// The coefficient matrix C of that basis, with c[i][k] the (integer) coefficient of input k in term i.
+template <int StateDim, int IOrder, int DOrder>
+struct FourierCoefficientTable {
+	int c[fourierNumTerms(StateDim, IOrder, DOrder)][StateDim];
+};
+
+// Same construction as FourierBasis::init: the dependent terms count up in base DOrder+1, input 0 being the fastest digit, then for
+// each input the independent terms of orders DOrder+1..IOrder.
+template <int StateDim, int IOrder, int DOrder>
+constexpr FourierCoefficientTable<StateDim, IOrder, DOrder> makeFourierCoefficientTable() {
+	FourierCoefficientTable<StateDim, IOrder, DOrder> t = {};
+	int counter[StateDim] = {};
+	const int dTerms = constexprPow(DOrder + 1, StateDim);
+	for (int i = 0; i < dTerms; i++) {
+		for (int k = 0; k < StateDim; k++)
+			t.c[i][k] = counter[k];
+		for (int k = 0; k < StateDim; k++) {
+			if (++counter[k] <= DOrder)
+				break;
+			counter[k] = 0;
+		}
+	}
+	int i = dTerms;
+	for (int k = 0; k < StateDim; k++)
+		for (int j = DOrder + 1; j <= IOrder; j++)
+			t.c[i++][k] = j;
+	return t;
+}
+
+// The Fourier basis for a state dimension and orders that are known at compile time. The coefficient matrix C is a constexpr table
+// built by the compiler, and the number of features is a compile-time constant, so the features fit in a std::array and every loop
+// over the terms or the inputs has a constant trip count that the compiler can unroll. The terms are in the same order as in
+// FourierBasis, and with the same CosineMode the features are bit-identical to FourierBasis::basify.
+// Use StaticFourierBasis in place of FourierBasis through StaticQLearning and StaticSarsa (see AgentDispatch.hpp for how the
+// specializations are chosen at runtime).
+template <int StateDim, int IOrder, int DOrder>
+class StaticFourierBasis {
+public:
+	static constexpr int stateDim = StateDim;
+	static constexpr int iOrder = IOrder;
+	static constexpr int dOrder = DOrder;
+
+	static constexpr int numTerms = fourierNumTerms(StateDim, IOrder, DOrder);
+
+	typedef std::array<double, numTerms> Features;
+
+	// A state, in the std::array the fixed-shape environments return (e.g. MountainCar::State for StateDim 2).
+	typedef std::array<double, StateDim> State;
+
+	// C, built by the compiler.
+	typedef FourierCoefficientTable<StateDim, IOrder, DOrder> CoefficientTable;
+	static constexpr CoefficientTable table = makeFourierCoefficientTable<StateDim, IOrder, DOrder>();
+
+	// Choose how the cosines are evaluated (see VectorMath.hpp). The default, CosineMode::Exact, matches FourierBasis bit-for-bit.
+	void setCosineMode(const CosineMode & mode);
+
+	// result = phi(x), where x points to StateDim inputs.
+	void basify(const double * x, Features & result) const;
+
+private:
+	CosineMode cosineMode = CosineMode::Exact;
+
+	// The loops over the terms and the inputs are written as pack expansions, so they are unrolled whatever the optimization level,
+	// and each coefficient is a template argument. Adding the product of a zero coefficient only adds +-0, so those are dropped at
+	// compile time, as the sparse path of FourierBasis does at runtime: the arguments are still bit-identical.
+	static void addProduct(double &, const double &, std::integral_constant<int, 0>) {}
+	template <int Coefficient>
+	static void addProduct(double & argument, const double & xk, std::integral_constant<int, Coefficient>) {
+		argument += (double)Coefficient * xk;
+	}
+
+	// c_i.x, accumulated in the order 0..StateDim-1 like FourierBasis does. (Braced initializer lists are evaluated in order.)
+	template <int Term, std::size_t... K>
+	static double argument(const double * x, std::index_sequence<K...>) {
+		double result = 0;
+		const int sequence[] = { (addProduct(result, x[K], std::integral_constant<int, table.c[Term][K]>()), 0)... };
+		(void)sequence;
+		return result;
+	}
+
+	// out[i] = c_i.x for every term i.
+	template <std::size_t... I>
+	static void computeArguments(const double * x, double * out, std::index_sequence<I...>) {
+		const int sequence[] = { (out[I] = argument<(int)I>(x, std::make_index_sequence<StateDim>()), 0)... };
+		(void)sequence;
+	}
+};
+
+// Definitions of the static constants, which are passed by reference
+template <int StateDim, int IOrder, int DOrder> constexpr int StaticFourierBasis<StateDim, IOrder, DOrder>::stateDim;
+template <int StateDim, int IOrder, int DOrder> constexpr int StaticFourierBasis<StateDim, IOrder, DOrder>::iOrder;
+template <int StateDim, int IOrder, int DOrder> constexpr int StaticFourierBasis<StateDim, IOrder, DOrder>::dOrder;
+template <int StateDim, int IOrder, int DOrder> constexpr int StaticFourierBasis<StateDim, IOrder, DOrder>::numTerms;
+template <int StateDim, int IOrder, int DOrder>
+constexpr typename StaticFourierBasis<StateDim, IOrder, DOrder>::CoefficientTable StaticFourierBasis<StateDim, IOrder, DOrder>::table;
+
+template <int StateDim, int IOrder, int DOrder>
+void StaticFourierBasis<StateDim, IOrder, DOrder>::setCosineMode(const CosineMode & mode) {
+	cosineMode = mode;
+}
+
+template <int StateDim, int IOrder, int DOrder>
+void StaticFourierBasis<StateDim, IOrder, DOrder>::basify(const double * x, Features & result) const {
+	computeArguments(x, result.data(), std::make_index_sequence<numTerms>());
+	cosPi(result.data(), result.data(), numTerms, cosineMode);
+}
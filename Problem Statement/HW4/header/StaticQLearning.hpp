@@ -0,0 +1,105 @@
+#pragma once
+
+#include "stdafx.h"
+
+/*
+QLearning with the features of a StaticFourierBasis<StateDim, IOrder, DOrder>, so the number of features is known at compile time:
+phi is a std::array, and the dot products and weight updates are unrolled for that length. The algorithm is the same as in
+QLearning.cpp, step for step, and gives bit-identical results for the same arguments and generator.
+The constructor takes the same arguments as QLearning's (so the two are interchangeable in runExperiment), and throws
+std::invalid_argument if stateDim, iOrder or dOrder do not match the template arguments. See AgentDispatch.hpp.
+The states are std::arrays (State): runExperiment passes the environment's own State when it has that shape (MountainCar, CartPole
+and Acrobot), so no state is on the heap, and the std::vector<double> overloads remain for the other environments.
+*/
+template <int StateDim, int IOrder, int DOrder>
+class StaticQLearning {
+public:
+	typedef StaticFourierBasis<StateDim, IOrder, DOrder> Basis;
+	typedef typename Basis::State State;
+
+	StaticQLearning(const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & iOrder, const int & dOrder);
+	void train(std::mt19937_64 & generator, const State & s, const int & a, double & r, const State & sPrime, const bool & sPrimeTerminal);
+	void newEpisode(std::mt19937_64 & generator);
+	int getAction(const State & s, std::mt19937_64 & generator);
+
+	// The same, for states given as a std::vector<double> of StateDim elements (copied into a State, on the stack).
+	void train(std::mt19937_64 & generator, const std::vector<double> & s, const int & a, double & r, const std::vector<double> & sPrime, const bool & sPrimeTerminal);
+	int getAction(const std::vector<double> & s, std::mt19937_64 & generator);
+
+	// Bytes held by each copy of this agent. The coefficient table is compiled into the program, so nothing is shared at runtime.
+	size_t getTrialMemory() const;
+	size_t getSharedMemory() const;
+
+private:
+	Basis fb;
+	WeightMatrix w;
+	int numActions;
+	double alpha, gamma;
+	typename Basis::Features phi;		// phi(s) during a call to train
+	FixedStepCache<Basis> cache;		// phi and q for the last state we evaluated
+	std::bernoulli_distribution d1;
+	std::uniform_int_distribution<int> d2;
+};
+
+template <int StateDim, int IOrder, int DOrder>
+StaticQLearning<StateDim, IOrder, DOrder>::StaticQLearning(const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & iOrder, const int & dOrder) : numActions(numActions), alpha(alpha), gamma(gamma) {
+	if ((stateDim != StateDim) || (iOrder != IOrder) || (dOrder != DOrder))
+		throw std::invalid_argument("StaticQLearning constructed with a stateDim, iOrder or dOrder that differs from its template arguments");
+	if (numActions > maxNumActions)
+		throw std::invalid_argument("StaticQLearning supports at most maxNumActions actions");
+	w.resize(numActions, Basis::numTerms);
+	phi.fill(0.0);
+	d1 = std::bernoulli_distribution(epsilon);
+	d2 = std::uniform_int_distribution<int>(0, numActions - 1);
+}
+
+template <int StateDim, int IOrder, int DOrder>
+void StaticQLearning<StateDim, IOrder, DOrder>::train(std::mt19937_64 & generator, const State & s, const int & a, double & r, const State & sPrime, const bool & sPrimeTerminal) {
+	if (cache.holds(s))
+		phi = cache.getPhi();
+	else
+		fb.basify(s.data(), phi);
+
+	double TDerror;
+	if (sPrimeTerminal)
+		TDerror = r - dotProduct<Basis::numTerms>(w.row(a), phi.data());
+	else {
+		cache.load(fb, sPrime, w);
+		TDerror = r + gamma * maxQValue(cache.getQ(), numActions) - dotProduct<Basis::numTerms>(w.row(a), phi.data());
+	}
+
+	addScaled<Basis::numTerms>(alpha * TDerror, phi.data(), w.row(a));
+	cache.refresh(w, a);
+}
+
+template <int StateDim, int IOrder, int DOrder>
+void StaticQLearning<StateDim, IOrder, DOrder>::newEpisode(std::mt19937_64 & generator) {
+}
+
+template <int StateDim, int IOrder, int DOrder>
+int StaticQLearning<StateDim, IOrder, DOrder>::getAction(const State & s, std::mt19937_64 & generator) {
+	if (d1(generator))
+		return d2(generator);
+	cache.load(fb, s, w);
+	return greedyAction(cache.getQ(), numActions, generator);
+}
+
+template <int StateDim, int IOrder, int DOrder>
+void StaticQLearning<StateDim, IOrder, DOrder>::train(std::mt19937_64 & generator, const std::vector<double> & s, const int & a, double & r, const std::vector<double> & sPrime, const bool & sPrimeTerminal) {
+	train(generator, toFixedState<StateDim>(s), a, r, toFixedState<StateDim>(sPrime), sPrimeTerminal);
+}
+
+template <int StateDim, int IOrder, int DOrder>
+int StaticQLearning<StateDim, IOrder, DOrder>::getAction(const std::vector<double> & s, std::mt19937_64 & generator) {
+	return getAction(toFixedState<StateDim>(s), generator);
+}
+
+template <int StateDim, int IOrder, int DOrder>
+size_t StaticQLearning<StateDim, IOrder, DOrder>::getTrialMemory() const {
+	return sizeof(StaticQLearning) + w.getMemory();
+}
+
+template <int StateDim, int IOrder, int DOrder>
+size_t StaticQLearning<StateDim, IOrder, DOrder>::getSharedMemory() const {
+	return 0;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "stdafx.h"
+
+/*
+Sarsa with the features of a StaticFourierBasis<StateDim, IOrder, DOrder>. This is to Sarsa what StaticQLearning is to QLearning:
+the same algorithm as in Sarsa.cpp, with fixed-size features, giving bit-identical results. See StaticQLearning.hpp.
+*/
+template <int StateDim, int IOrder, int DOrder>
+class StaticSarsa {
+public:
+	typedef StaticFourierBasis<StateDim, IOrder, DOrder> Basis;
+	typedef typename Basis::State State;
+
+	StaticSarsa(const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & iOrder, const int & dOrder);
+	void train(std::mt19937_64 & generator, const State & s, const int & a, double & r, const State & sPrime, const bool & sPrimeTerminal);
+	void newEpisode(std::mt19937_64 & generator);
+	int getAction(const State & s, std::mt19937_64 & generator);
+
+	// The same, for states given as a std::vector<double> of StateDim elements (copied into a State, on the stack).
+	void train(std::mt19937_64 & generator, const std::vector<double> & s, const int & a, double & r, const std::vector<double> & sPrime, const bool & sPrimeTerminal);
+	int getAction(const std::vector<double> & s, std::mt19937_64 & generator);
+
+	// Bytes held by each copy of this agent. The coefficient table is compiled into the program, so nothing is shared at runtime.
+	size_t getTrialMemory() const;
+	size_t getSharedMemory() const;
+
+private:
+	Basis fb;
+	WeightMatrix w;
+	int numActions;
+	double alpha, gamma;
+	std::bernoulli_distribution d1;
+	std::uniform_int_distribution<int> d2;
+
+	typename Basis::Features phi_s;
+	bool flag = false;
+	int previous_a;
+	double previous_r;
+
+	FixedStepCache<Basis> cache;
+};
+
+template <int StateDim, int IOrder, int DOrder>
+StaticSarsa<StateDim, IOrder, DOrder>::StaticSarsa(const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & iOrder, const int & dOrder) : numActions(numActions), alpha(alpha), gamma(gamma) {
+	if ((stateDim != StateDim) || (iOrder != IOrder) || (dOrder != DOrder))
+		throw std::invalid_argument("StaticSarsa constructed with a stateDim, iOrder or dOrder that differs from its template arguments");
+	if (numActions > maxNumActions)
+		throw std::invalid_argument("StaticSarsa supports at most maxNumActions actions");
+	w.resize(numActions, Basis::numTerms);
+	d1 = std::bernoulli_distribution(epsilon);
+	d2 = std::uniform_int_distribution<int>(0, numActions - 1);
+}
+
+template <int StateDim, int IOrder, int DOrder>
+void StaticSarsa<StateDim, IOrder, DOrder>::train(std::mt19937_64 & generator, const State & s, const int & a, double & r, const State & sPrime, const bool & sPrimeTerminal) {
+	cache.load(fb, s, w);
+	const typename Basis::Features & phi_s_dash = cache.getPhi();
+
+	if (flag == true) {
+		double term3 = dotProduct<Basis::numTerms>(w.row(previous_a), phi_s.data());
+		double term2 = gamma * cache.getQ()[a];
+		double TDerror = previous_r + term2 - term3;
+		addScaled<Basis::numTerms>(alpha * TDerror, phi_s.data(), w.row(previous_a));
+		cache.refresh(w, previous_a);
+
+		if (sPrimeTerminal == true) {
+			double term3 = cache.getQ()[a];
+			double term2 = gamma * 0.0;
+			double TDerror = r + term2 - term3;
+			addScaled<Basis::numTerms>(alpha * TDerror, phi_s_dash.data(), w.row(a));
+			cache.refresh(w, a);
+		}
+	}
+
+	flag = true;
+	previous_a = a;
+	previous_r = r;
+	phi_s = phi_s_dash;
+}
+
+template <int StateDim, int IOrder, int DOrder>
+void StaticSarsa<StateDim, IOrder, DOrder>::newEpisode(std::mt19937_64 & generator) {
+	flag = false;
+}
+
+template <int StateDim, int IOrder, int DOrder>
+int StaticSarsa<StateDim, IOrder, DOrder>::getAction(const State & s, std::mt19937_64 & generator) {
+	if (d1(generator))
+		return d2(generator);
+	cache.load(fb, s, w);
+	return greedyAction(cache.getQ(), numActions, generator);
+}
+
+template <int StateDim, int IOrder, int DOrder>
+void StaticSarsa<StateDim, IOrder, DOrder>::train(std::mt19937_64 & generator, const std::vector<double> & s, const int & a, double & r, const std::vector<double> & sPrime, const bool & sPrimeTerminal) {
+	train(generator, toFixedState<StateDim>(s), a, r, toFixedState<StateDim>(sPrime), sPrimeTerminal);
+}
+
+template <int StateDim, int IOrder, int DOrder>
+int StaticSarsa<StateDim, IOrder, DOrder>::getAction(const std::vector<double> & s, std::mt19937_64 & generator) {
+	return getAction(toFixedState<StateDim>(s), generator);
+}
+
+template <int StateDim, int IOrder, int DOrder>
+size_t StaticSarsa<StateDim, IOrder, DOrder>::getTrialMemory() const {
+	return sizeof(StaticSarsa) + w.getMemory();
+}
+
+template <int StateDim, int IOrder, int DOrder>
+size_t StaticSarsa<StateDim, IOrder, DOrder>::getSharedMemory() const {
+	return 0;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "stdafx.h"
+
+/*
+Runs many experiments, each the numTrials trials of runExperiment for one agent and environment (e.g. one point of a grid search, for
+Q-learning or for Sarsa), as one flat pool of trial tasks on a persistent ThreadPool. A whole sweep (grid x agent x trial) is queued
+up front, and the workers take trials from it in order, so a thread that finishes the last trials of one configuration moves on to
+the next one instead of waiting at a barrier for the slowest trial. The results are streamed: when the last trial of an experiment
+finishes, the mean and variance of its returns are computed and passed to its handler right away, on the worker thread, one handler
+at a time.
+Each trial copies the agent and the environment when it starts (so a sweep holds one copy per running trial, not per queued one), and
+uses a generator seeded with its trial number, so the results are bit-identical to those of runExperiment.
+*/
+class SweepEngine {
+public:
+	// Receives the mean and the sample variance of the returns of each episode (runExperiment's meanBuff and varBuff).
+	typedef std::function<void(const std::vector<double> & means, const std::vector<double> & vars)> ResultHandler;
+
+	// verbose makes wait print the utilization of the pool's threads.
+	explicit SweepEngine(ThreadPool & pool = ThreadPool::shared(), const bool & verbose = false);
+
+	// Waits for the experiments that are still running.
+	~SweepEngine();
+
+	// Queue the numTrials trials of runExperiment(a, e, numTrials, numEpisodes, maxEpisodeLength, gamma, ...), and call onDone with
+	// its results when the last one has finished. Returns at once.
+	template <typename Agent, typename Environment>
+	void add(const Agent & a, const Environment & e, const int & numTrials, const int & numEpisodes, const int & maxEpisodeLength, const double & gamma, const ResultHandler & onDone);
+
+	// Block until every experiment added so far has finished and its handler has run. When verbose, print the utilization of the
+	// pool's threads since the first of them was added.
+	void wait();
+
+private:
+	struct Experiment {
+		std::vector<std::vector<double>> returns;	// returns[trial][episode]
+		std::atomic<int> remaining;					// Trials that have not finished
+		ResultHandler onDone;
+	};
+
+	// Called by each trial of experiment when it ends. The last one computes the statistics and runs the handler.
+	void finishTrial(Experiment & experiment);
+
+	// Record the start of a sweep, for the utilization report, unless one is running.
+	void begin();
+
+	ThreadPool & pool;
+	const bool verbose;
+	std::mutex handlerLock;				// Runs the handlers one at a time
+	bool running;
+	std::chrono::steady_clock::time_point start;
+	std::vector<double> busyAtStart;	// The pool's busy seconds at start
+};
+
+template <typename Agent, typename Environment>
+void SweepEngine::add(const Agent & a, const Environment & e, const int & numTrials, const int & numEpisodes, const int & maxEpisodeLength, const double & gamma, const ResultHandler & onDone) {
+	begin();
+	std::shared_ptr<Experiment> experiment = std::make_shared<Experiment>();
+	experiment->returns.assign(numTrials, std::vector<double>(numEpisodes, 0.0));
+	experiment->remaining = numTrials;
+	experiment->onDone = onDone;
+	std::shared_ptr<const Agent> agentPrototype = std::make_shared<Agent>(a);
+	std::shared_ptr<const Environment> environmentPrototype = std::make_shared<Environment>(e);
+	for (int trial = 0; trial < numTrials; trial++) {
+		pool.submit([=]() {
+			// One trial of runExperiment, with the same loop (see TrialEpisodes.hpp).
+			Agent agent(*agentPrototype);
+			Environment environment(*environmentPrototype);
+			std::mt19937_64 generator(trial);
+			typename ObservationType<Agent, Environment>::type state, nextState;
+			runTrialEpisodes(agent, environment, generator, state, nextState, 0, numEpisodes, maxEpisodeLength, gamma, experiment->returns[trial]);
+			finishTrial(*experiment);
+		});
+	}
+	if (numTrials == 0)
+		finishTrial(*experiment);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "stdafx.h"
+
+/*
+Tabular Q-learning for environments with a finite number of states, such as Gridworld. The agent takes the id of the state
+(0..numStates-1) instead of a feature vector: it declares Observation as int, so runExperiment asks the environment for the id
+(see ObservationType.hpp), and keeps one value per state and action in a Table. A step reads q(s',.) and updates q(s,a): O(1)
+work, and no basis at all. This is what QLearning with iOrder 1 and dOrder 0 approximates on one-hot states, without the cosines
+and the dot products over every state.
+Table is QTable (TabularQLearning: a dense table, numStates*numActions doubles per trial) or PagedQTable (PagedTabularQLearning:
+only the states that have been updated, for maps too large for a dense table). Both give the same results. The values are read
+through the const table, so only the updated state is materialized in a PagedQTable.
+*/
+template <typename Table>
+class BasicTabularQLearning {
+public:
+	typedef int Observation;
+
+	BasicTabularQLearning(const int & numStates, const int & numActions, const double & alpha, const double & gamma, const double & epsilon);
+	void train(std::mt19937_64 & generator, const int & s, const int & a, double & r, const int & sPrime, const bool & sPrimeTerminal);
+	void newEpisode(std::mt19937_64 & generator);
+	int getAction(const int & s, std::mt19937_64 & generator);
+
+	// q(s,a), for checks.
+	double getQ(const int & s, const int & a) const;
+
+	// The table, and the number of times it allocated after the constructor (only a PagedQTable does; runExperiment allows the
+	// steps that did to allocate).
+	const Table & getTable() const;
+	long long getNumTableGrowths() const;
+
+	// Bytes held by each copy of this agent (the table). Nothing is shared.
+	size_t getTrialMemory() const;
+	size_t getSharedMemory() const;
+
+private:
+	Table q;
+	int numActions;
+	double alpha, gamma;
+	std::bernoulli_distribution d1;
+	std::uniform_int_distribution<int> d2;
+};
+
+typedef BasicTabularQLearning<QTable> TabularQLearning;
+typedef BasicTabularQLearning<PagedQTable> PagedTabularQLearning;
+
+template <typename Table>
+BasicTabularQLearning<Table>::BasicTabularQLearning(const int & numStates, const int & numActions, const double & alpha, const double & gamma, const double & epsilon) : numActions(numActions), alpha(alpha), gamma(gamma) {
+	q.resize(numStates, numActions);
+	d1 = std::bernoulli_distribution(epsilon);
+	d2 = std::uniform_int_distribution<int>(0, numActions - 1);
+}
+
+template <typename Table>
+void BasicTabularQLearning<Table>::train(std::mt19937_64 & generator, const int & s, const int & a, double & r, const int & sPrime, const bool & sPrimeTerminal) {
+	const Table & table = q;
+	const double target = sPrimeTerminal ? r : r + gamma * maxQValue(table.row(sPrime), numActions);	// q(terminal state, any action) = 0
+	double & qsa = q.row(s)[a];
+	qsa += alpha * (target - qsa);
+}
+
+template <typename Table>
+void BasicTabularQLearning<Table>::newEpisode(std::mt19937_64 & generator) {
+}
+
+template <typename Table>
+int BasicTabularQLearning<Table>::getAction(const int & s, std::mt19937_64 & generator) {
+	if (d1(generator))
+		return d2(generator);
+	const Table & table = q;
+	return greedyAction(table.row(s), numActions, generator);
+}
+
+template <typename Table>
+double BasicTabularQLearning<Table>::getQ(const int & s, const int & a) const {
+	return q.row(s)[a];
+}
+
+template <typename Table>
+const Table & BasicTabularQLearning<Table>::getTable() const {
+	return q;
+}
+
+template <typename Table>
+long long BasicTabularQLearning<Table>::getNumTableGrowths() const {
+	return q.getNumGrowths();
+}
+
+template <typename Table>
+size_t BasicTabularQLearning<Table>::getTrialMemory() const {
+	return sizeof(BasicTabularQLearning) + q.getMemory();
+}
+
+template <typename Table>
+size_t BasicTabularQLearning<Table>::getSharedMemory() const {
+	return 0;
+}
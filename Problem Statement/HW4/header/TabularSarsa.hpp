@@ -0,0 +1,107 @@
+#pragma once
+
+#include "stdafx.h"
+
+/*
+Tabular Sarsa: the algorithm in Sarsa.cpp with a Table indexed by state id instead of linear features. See TabularQLearning.hpp.
+*/
+template <typename Table>
+class BasicTabularSarsa {
+public:
+	typedef int Observation;
+
+	BasicTabularSarsa(const int & numStates, const int & numActions, const double & alpha, const double & gamma, const double & epsilon);
+	void train(std::mt19937_64 & generator, const int & s, const int & a, double & r, const int & sPrime, const bool & sPrimeTerminal);
+	void newEpisode(std::mt19937_64 & generator);
+	int getAction(const int & s, std::mt19937_64 & generator);
+
+	// q(s,a), for checks.
+	double getQ(const int & s, const int & a) const;
+
+	// The table, and the number of times it allocated after the constructor. See TabularQLearning.hpp.
+	const Table & getTable() const;
+	long long getNumTableGrowths() const;
+
+	// Bytes held by each copy of this agent (the table). Nothing is shared.
+	size_t getTrialMemory() const;
+	size_t getSharedMemory() const;
+
+private:
+	Table q;
+	int numActions;
+	double alpha, gamma;
+	std::bernoulli_distribution d1;
+	std::uniform_int_distribution<int> d2;
+
+	bool flag = false;
+	int previous_s, previous_a;
+	double previous_r;
+};
+
+typedef BasicTabularSarsa<QTable> TabularSarsa;
+typedef BasicTabularSarsa<PagedQTable> PagedTabularSarsa;
+
+template <typename Table>
+BasicTabularSarsa<Table>::BasicTabularSarsa(const int & numStates, const int & numActions, const double & alpha, const double & gamma, const double & epsilon) : numActions(numActions), alpha(alpha), gamma(gamma) {
+	q.resize(numStates, numActions);
+	d1 = std::bernoulli_distribution(epsilon);
+	d2 = std::uniform_int_distribution<int>(0, numActions - 1);
+}
+
+// The update of Sarsa::train: the previous (s, a, r) is updated towards r + gamma*q(s,a) once a, the action taken in s, is known,
+// and (s, a) itself when sPrime is terminal. q(s,a) is read through the const table and each write takes its row again, since
+// materializing a row of a PagedQTable can move the others.
+template <typename Table>
+void BasicTabularSarsa<Table>::train(std::mt19937_64 & generator, const int & s, const int & a, double & r, const int & sPrime, const bool & sPrimeTerminal) {
+	const Table & table = q;
+	if (flag == true) {
+		double & previous_q = q.row(previous_s)[previous_a];
+		previous_q += alpha * (previous_r + gamma * table.row(s)[a] - previous_q);
+		if (sPrimeTerminal == true) {
+			double & qsa = q.row(s)[a];
+			qsa += alpha * (r - qsa);
+		}
+	}
+	flag = true;
+	previous_s = s;
+	previous_a = a;
+	previous_r = r;
+}
+
+template <typename Table>
+void BasicTabularSarsa<Table>::newEpisode(std::mt19937_64 & generator) {
+	flag = false;
+}
+
+template <typename Table>
+int BasicTabularSarsa<Table>::getAction(const int & s, std::mt19937_64 & generator) {
+	if (d1(generator))
+		return d2(generator);
+	const Table & table = q;
+	return greedyAction(table.row(s), numActions, generator);
+}
+
+template <typename Table>
+double BasicTabularSarsa<Table>::getQ(const int & s, const int & a) const {
+	return q.row(s)[a];
+}
+
+template <typename Table>
+const Table & BasicTabularSarsa<Table>::getTable() const {
+	return q;
+}
+
+template <typename Table>
+long long BasicTabularSarsa<Table>::getNumTableGrowths() const {
+	return q.getNumGrowths();
+}
+
+template <typename Table>
+size_t BasicTabularSarsa<Table>::getTrialMemory() const {
+	return sizeof(BasicTabularSarsa) + q.getMemory();
+}
+
+template <typename Table>
+size_t BasicTabularSarsa<Table>::getSharedMemory() const {
+	return 0;
+}
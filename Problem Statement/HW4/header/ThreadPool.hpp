@@ -0,0 +1,46 @@
+#pragma once
+
+#include "stdafx.h"
+
+/*
+A fixed set of worker threads that run submitted tasks in the order they were submitted, and stay alive between batches of tasks,
+so a long run of small jobs (a whole hyperparameter sweep, see SweepEngine.hpp) starts its threads once instead of opening and
+joining an OpenMP region per job. Each worker keeps the time it spent running tasks, to report utilization.
+*/
+class ThreadPool {
+public:
+	// numThreads workers (at least one); 0 for one per core (omp_get_max_threads with OpenMP, so OMP_NUM_THREADS applies).
+	explicit ThreadPool(const int & numThreads = 0);
+
+	// Finishes the queued tasks, then stops the workers.
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool & operator=(const ThreadPool &) = delete;
+
+	// The pool shared by the whole program, created on first use.
+	static ThreadPool & shared();
+
+	int getNumThreads() const;
+
+	// Queue task to run on one of the workers. task must not throw.
+	void submit(std::function<void()> task);
+
+	// Block until every submitted task has run.
+	void wait();
+
+	// Seconds each worker has spent running tasks since the pool was created.
+	std::vector<double> getBusySeconds() const;
+
+private:
+	void work(const int & worker);
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	mutable std::mutex lock;				// Guards tasks, numRunning, stopping and busySeconds
+	std::condition_variable taskReady;		// Signalled when a task is queued, or when stopping
+	std::condition_variable idle;			// Signalled when the last task finishes
+	int numRunning;
+	bool stopping;
+	std::vector<double> busySeconds;
+};
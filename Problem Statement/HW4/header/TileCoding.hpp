@@ -0,0 +1,38 @@
+#pragma once
+
+#include "stdafx.h"
+
+// A tile-coding basis: an alternative to FourierBasis whose features are binary and sparse. The input space [0,1]^inputDimension
+// (the range the environments normalize their states to; inputs outside it are clamped) is covered by numTilings grids of
+// tilesPerDimension tiles per input, each grid shifted by a different fraction of a tile. Every state is in exactly one tile of
+// each grid, so phi(s) has numTilings ones and zeros everywhere else, and basify returns only the indices of those tiles.
+// q(s,a) is then the sum of numTilings weights, and a TD update changes numTilings weights (see WeightMatrix::sumAt and addAt),
+// whatever the number of features. Each grid has tilesPerDimension+1 tiles per input, so that the shifted grids still cover [0,1].
+class TileCoding
+{
+public:
+	void init(const int & inputDimension, const int & numTilings, const int & tilesPerDimension);
+
+	// Number of features (tiles, over all of the tilings).
+	int getNumOutputs() const;
+
+	// Number of active features of every state: numTilings.
+	int getNumActive() const;
+
+	int getInputDimension() const;
+
+	// The indices of the active tiles of x, one per tiling, in increasing order, into active[0..numTilings-1].
+	void basify(const double * x, int * active) const;
+
+	// Same as above, with active resized to numTilings.
+	void basify(const std::vector<double> & x, std::vector<int> & active) const;
+
+	// Bytes of the whole basis.
+	size_t getMemory() const;
+
+private:
+	int inputDimension, numTilings, tilesPerDimension;
+	int tilesPerTiling;					// (tilesPerDimension+1)^inputDimension
+	std::vector<double> offset;			// offset[t*inputDimension + k]: shift of tiling t along input k, in tiles (in [0,1))
+	std::vector<int> placeValue;		// placeValue[k] = (tilesPerDimension+1)^k, to turn tile coordinates into an index
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "stdafx.h"
+
+/*
+QLearning with tile-coding features (see TileCoding.hpp) instead of the Fourier basis. The algorithm is the one in QLearning.cpp,
+but phi(s) is the list of the numTilings active tiles of s, so computing q(s,a) and updating w[a] each touch numTilings weights
+instead of every feature. A step costs O(numActions * numTilings), whatever the resolution of the tilings.
+The constructor takes the tiling parameters in place of iOrder and dOrder. Since every state has numTilings active features, alpha
+is usually chosen as a step size divided by numTilings.
+*/
+class TileCodingQLearning {
+public:
+	TileCodingQLearning(const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & numTilings, const int & tilesPerDimension);
+	void train(std::mt19937_64 & generator, const std::vector<double> & s, const int & a, double & r, const std::vector<double> & sPrime, const bool & sPrimeTerminal);
+	void newEpisode(std::mt19937_64 & generator);
+	int getAction(const std::vector<double> & s, std::mt19937_64 & generator);
+
+	// Bytes held by each copy of this agent, and by the tiling that all copies share (see QLearning.hpp).
+	size_t getTrialMemory() const;
+	size_t getSharedMemory() const;
+
+private:
+	std::shared_ptr<const TileCoding> tc;	// Read-only after the constructor, and shared by every copy of this agent
+	WeightMatrix w;
+	int numActions, numTilings;
+	double alpha, gamma;
+	std::vector<int> active;				// The active tiles of s during a call to train
+	TileStepCache cache;					// Active tiles and q for the last state we evaluated
+	std::bernoulli_distribution d1;
+	std::uniform_int_distribution<int> d2;
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "stdafx.h"
+
+/*
+Sarsa with tile-coding features. This is to Sarsa what TileCodingQLearning is to QLearning: the algorithm in Sarsa.cpp, with
+q-values and updates that only touch the numTilings active tiles. See TileCodingQLearning.hpp.
+*/
+class TileCodingSarsa {
+public:
+	TileCodingSarsa(const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & numTilings, const int & tilesPerDimension);
+	void train(std::mt19937_64 & generator, const std::vector<double> & s, const int & a, double & r, const std::vector<double> & sPrime, const bool & sPrimeTerminal);
+	void newEpisode(std::mt19937_64 & generator);
+	int getAction(const std::vector<double> & s, std::mt19937_64 & generator);
+
+	// Bytes held by each copy of this agent, and by the tiling that all copies share (see QLearning.hpp).
+	size_t getTrialMemory() const;
+	size_t getSharedMemory() const;
+
+private:
+	std::shared_ptr<const TileCoding> tc;
+	WeightMatrix w;
+	int numActions, numTilings;
+	double alpha, gamma;
+	std::bernoulli_distribution d1;
+	std::uniform_int_distribution<int> d2;
+
+	std::vector<int> active_s;		// The active tiles of the previous state
+	bool flag = false;
+	int previous_a;
+	double previous_r;
+
+	TileStepCache cache;
+};
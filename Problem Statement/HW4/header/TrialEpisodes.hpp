@@ -0,0 +1,44 @@
+#pragma once
+
+#include "stdafx.h"
+
+// The number of times the table of a tabular agent with a PagedQTable has allocated (see TabularQLearning.hpp), and 0 for the
+// agents that do not report it, whose buffers all have their final size after the first episode.
+template <typename Agent>
+auto agentTableGrowths(const Agent & a, int) -> decltype(a.getNumTableGrowths()) {
+	return a.getNumTableGrowths();
+}
+
+template <typename Agent>
+long long agentTableGrowths(const Agent &, long) {
+	return 0;
+}
+
+// Episodes firstEpisode up to lastEpisode (excluded) of one trial of runExperiment: agent learns on environment, drawing from
+// generator, and the discounted return (with the plotting gamma) of each episode is added to returns[episode]. state and nextState
+// are the trial's buffers, kept by the caller so that a trial run in several calls (see TrialScheduler.hpp) only allocates them once.
+// This is the one loop that runExperiment and SweepEngine both use, so their results stay bit-identical.
+template <typename Agent, typename Environment>
+void runTrialEpisodes(Agent & agent, Environment & environment, std::mt19937_64 & generator, typename ObservationType<Agent, Environment>::type & state, typename ObservationType<Agent, Environment>::type & nextState, const int & firstEpisode, const int & lastEpisode, const int & maxEpisodeLength, const double & gamma, std::vector<double> & returns) {
+	for (int episode = firstEpisode; episode < lastEpisode; episode++) {	// Loop over episodes
+		double curGamma = 1.0;					// We plot the discounted return - this stores gamma^t, which starts at 1.
+		bool inTerminalState = false;			// We will use this flag to determine when we should terminate the loop below. If environment.inTerminalState() is slow to call, this saves us from calling it a couple times. For our MDPs it really doesn't matter that we're doing this more efficiently.
+		environment.newEpisode(generator);		// Reset the environment, telling it to start a new episode.
+		agent.newEpisode(generator);			// Tell the agent that we are starting a new episode. 
+		environment.getState(generator, state);	// Get the initial state.
+		for (int t = 0; (t < maxEpisodeLength) && (!inTerminalState); t++) {	// Loop over time steps in the episode, stopping when we hit the max episode length or when we enter a terminal state.
+			long long allocations = getThreadAllocationCount(), growths = agentTableGrowths(agent, 0);
+			int action = agent.getAction(state, generator);			// Get the current action
+			double reward = environment.update(action, generator);	// Apply the action by updating the environment with the chosen action, and get the resulting reward.
+			returns[episode] += curGamma * reward;					// Update the expected return for the current episode.
+			environment.getState(generator, nextState);			// Get the resulting state of the environment from this transition
+			inTerminalState = environment.inTerminalState();		// Store whether this is next-state is a terminal state.
+			agent.train(generator, state, action, reward, nextState, inTerminalState);	// Update the agent, telling it if "nextState" is a terminal state.
+			std::swap(state, nextState);							// Prepare for the next iteration of the loop with this line and the next.
+			curGamma *= gamma;
+			// After the first episode every buffer has its final size, so a step must not allocate (only checked in debug builds),
+			// unless it materialized a new page of a PagedQTable.
+			assert((episode == 0) || (getThreadAllocationCount() == allocations) || (agentTableGrowths(agent, 0) != growths));
+		}
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "stdafx.h"
+
+/*
+Runs the trials of runExperiment on the OpenMP threads with work stealing. Each trial is split into numChunks chunks (runs of
+consecutive episodes) that must run in order, so a task is the next chunk of a trial, and a trial can move to another thread
+between two of its chunks. Each thread has its own queue of trials, and always runs the one with the largest expected remaining
+time; a thread whose queue is empty steals that trial from the other queues. So the longest trials start first, and threads that
+run out of work take over trials that are waiting, rather than sitting idle while a few long trials finish.
+
+The expected remaining time of a trial is its measured time per chunk so far times its remaining chunks, once a chunk has run.
+Before that it is the given expected time of the trial (runExperiment passes the trial times its caller kept from an earlier, similar
+experiment, if any), or the mean chunk time measured so far times numChunks if there is none.
+*/
+class TrialScheduler {
+public:
+	// Chunks per trial that runExperiment uses (fewer if there are fewer episodes).
+	static const int defaultChunksPerTrial = 8;
+
+	// numTrials trials of numChunks chunks each. expectedSeconds[t], if given, is the expected run time of trial t.
+	TrialScheduler(const int & numTrials, const int & numChunks, const std::vector<double> & expectedSeconds = std::vector<double>());
+
+	// Call task(trial, chunk) for every trial and chunk, the chunks of a trial in order and one at a time, on the OpenMP threads.
+	// Returns when they have all run. task must not throw.
+	void run(const std::function<void(int, int)> & task);
+
+	// Seconds that each trial took in the last run, to pass as expectedSeconds next time.
+	const std::vector<double> & getTrialSeconds() const;
+
+	// Print how busy each thread was during the last run: the fraction of the run's wall time it spent in tasks, the chunks it ran
+	// and how many trials it stole.
+	void reportUtilization() const;
+
+private:
+	// The trial with the largest expected remaining time in queues[q], removed from it, or -1 if it is empty. Needs locks[q].
+	int popLongest(const int & q);
+
+	// The next trial for thread q: from its own queue, or stolen from another queue. -1 if every queue is empty.
+	int take(const int & q);
+
+	// Wake one waiting thread (a trial was queued), or all of them (the last trial finished).
+	void wake(const bool & all);
+
+	double expectedRemaining(const int & trial) const;
+
+	int numTrials, numChunks;
+	std::vector<double> expected;			// expected[t]: expected run time of trial t, or a negative number if unknown
+	std::vector<double> trialSeconds;		// Time spent in the chunks of each trial that have run
+	std::vector<int> nextChunk;				// The next chunk of each trial
+	std::vector<std::vector<int>> queues;	// The trials waiting for each thread
+	std::unique_ptr<std::mutex[]> locks;	// locks[q] guards queues[q]
+	std::mutex statsLock;					// Guards chunkSecondsSum and numChunksRun
+	double chunkSecondsSum;
+	int numChunksRun;
+	std::atomic<double> meanChunkSeconds;	// chunkSecondsSum / numChunksRun, read without the lock
+	std::atomic<int> numUnfinished;			// Trials that still have chunks to run
+	std::atomic<int> numQueued;				// Trials waiting in the queues
+	std::mutex waitLock;					// With workQueued, puts the threads that find every queue empty to sleep
+	std::condition_variable workQueued;		// Signalled when a trial is queued, and when the last one finishes
+
+	// Statistics of the last run, per thread.
+	double wallSeconds;
+	std::vector<double> busySeconds;
+	std::vector<int> chunksRun, steals;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "stdafx.h"
+
+// The weights of a linear action-value function, w[numRows][numColumns] with one row per action, stored in a single aligned
+// buffer. Each row is padded to a whole number of cache lines (the padding stays zero), so every row starts on an aligned address
+// and the rows of all of the actions sit next to each other in memory. Products and updates use the kernels in VectorMath.hpp.
+class WeightMatrix {
+public:
+	// An empty matrix. Use resize before use.
+	WeightMatrix();
+
+	// A numRows x numColumns matrix of zeros.
+	WeightMatrix(const int & numRows, const int & numColumns);
+
+	// Make this a numRows x numColumns matrix of zeros.
+	void resize(const int & numRows, const int & numColumns);
+
+	int getNumRows() const;
+	int getNumColumns() const;
+
+	// Distance, in doubles, between the starts of two consecutive rows.
+	int getStride() const;
+
+	// Bytes held by the buffer.
+	size_t getMemory() const;
+
+	// Pointer to the first element of row a.
+	double * row(const int & a);
+	const double * row(const int & a) const;
+
+	// dot(w[a], phi), with the summation order of dotProduct. phi must have numColumns elements.
+	double dot(const int & a, const std::vector<double> & phi) const;
+
+	// w[a] += scale*phi.
+	void addScaled(const int & a, const double & scale, const std::vector<double> & phi);
+
+	// The same two operations for binary features given by the indices of their ones, active[0..count-1] (see TileCoding.hpp):
+	// the sum of w[a][active[j]], and w[a][active[j]] += value for every j.
+	double sumAt(const int & a, const int * active, const int & count) const;
+	void addAt(const int & a, const double & value, const int * active, const int & count);
+
+private:
+	int numRows, numColumns, stride;
+	AlignedVector data;
+};
@@ -6,22 +6,77 @@
 #include <fstream>
 #include <random>
 #include <vector>
+#include <set>
 #include <algorithm>
 #define _USE_MATH_DEFINES 
 #include <math.h>
 #include <climits>
 #include<string>
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <chrono>
+#include <array>
+#include <memory>
+#include <utility>
+#include <type_traits>
+#include <stdexcept>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <deque>
+#include <condition_variable>
 
 // Tools
+#include "AllocationCounter.hpp"
+#include "AlignedAllocator.hpp"
 #include "MathUtils.hpp"
+#include "VectorMath.hpp"
+#include "WeightMatrix.hpp"
+#include "SparseState.hpp"
+#include "ShiftedWeightMatrix.hpp"
 #include "FourierBasis.hpp"
+#include "StaticFourierBasis.hpp"
+#include "IncrementalFeatures.hpp"
+#include "FeatureCache.hpp"
+#include "TileCoding.hpp"
+#include "QValues.hpp"
+#include "QTable.hpp"
+#include "ObservationType.hpp"
+#include "LaneFeatures.hpp"
+#include "TrialScheduler.hpp"
+#include "ThreadPool.hpp"
 
 // Environments
 #include "MountainCar.hpp"
 #include "CartPole.hpp"
 #include "Acrobot.hpp"
+#include "GridMap.hpp"
 #include "Gridworld.hpp"
+#include "BatchedMountainCar.hpp"
+#include "BatchedCartPole.hpp"
+#include "BatchedAcrobot.hpp"
 
 // Agents
 #include "QLearning.hpp"
-#include "Sarsa.hpp"
\ No newline at end of file
+#include "Sarsa.hpp"
+#include "StaticQLearning.hpp"
+#include "StaticSarsa.hpp"
+#include "TileCodingQLearning.hpp"
+#include "TileCodingSarsa.hpp"
+#include "TabularQLearning.hpp"
+#include "TabularSarsa.hpp"
+#include "AgentDispatch.hpp"
+#include "LockstepQLearning.hpp"
+#include "LockstepSarsa.hpp"
+#include "LockstepRunner.hpp"
+#include "TrialEpisodes.hpp"
+#include "SweepEngine.hpp"
+
+// Benchmarks
+#include "Benchmarks.hpp"
\ No newline at end of file
@@ -2,17 +2,20 @@
 
 using namespace std;
 
+constexpr int Acrobot::stateDim;
+constexpr int Acrobot::numActions;
+
 Acrobot::Acrobot() {
 	mt19937_64 generator(0);
 	newEpisode(generator);
 }
 
 int Acrobot::getStateDim() const {
-	return 4;
+	return stateDim;
 }
 
 int Acrobot::getNumActions() const {
-	return 3;
+	return numActions;
 }
 
 double Acrobot::update(const int & action, mt19937_64 & generator) {
@@ -66,12 +69,25 @@ double Acrobot::update(const int & action, mt19937_64 & generator) {
 }
 
 vector<double> Acrobot::getState(mt19937_64 & generator) {
-	vector<double> result(4);
+	vector<double> result;
+	getState(generator, result);
+	return result;
+}
+
+void Acrobot::getState(mt19937_64 & generator, vector<double> & result) {
+	result.resize(stateDim);
+	writeState(result.data());
+}
+
+void Acrobot::getState(mt19937_64 & generator, State & result) {
+	writeState(result.data());
+}
+
+void Acrobot::writeState(double * result) const {
 	result[0] = normalize(theta1, -M_PI, M_PI);
 	result[1] = normalize(theta2, -M_PI, M_PI);
 	result[2] = normalize(theta1Dot, -4.0*M_PI, 4.0*M_PI);
 	result[3] = normalize(theta2Dot, -9.0*M_PI, 9.0*M_PI);
-	return result;
 }
 
 bool Acrobot::inTerminalState() const {
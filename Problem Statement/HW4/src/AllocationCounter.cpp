@@ -0,0 +1,66 @@
+#include "stdafx.h"
+
+using namespace std;
+
+#ifdef COUNT_ALLOCATIONS
+
+static thread_local long long threadAllocationCount = 0;
+
+long long getThreadAllocationCount() {
+	return threadAllocationCount;
+}
+
+// Replacements for the global allocation functions. The array and nothrow forms are implemented in terms of these by the
+// standard library, but not reliably on every platform, so they are all replaced.
+void * operator new(size_t size) {
+	threadAllocationCount++;
+	void * p = malloc((size == 0) ? 1 : size);
+	if (p == nullptr)
+		throw bad_alloc();
+	return p;
+}
+
+void * operator new[](size_t size) {
+	return operator new(size);
+}
+
+void * operator new(size_t size, const nothrow_t &) noexcept {
+	threadAllocationCount++;
+	return malloc((size == 0) ? 1 : size);
+}
+
+void * operator new[](size_t size, const nothrow_t & tag) noexcept {
+	return operator new(size, tag);
+}
+
+void operator delete(void * p) noexcept {
+	free(p);
+}
+
+void operator delete[](void * p) noexcept {
+	free(p);
+}
+
+void operator delete(void * p, size_t) noexcept {
+	free(p);
+}
+
+void operator delete[](void * p, size_t) noexcept {
+	free(p);
+}
+
+void operator delete(void * p, const nothrow_t &) noexcept {
+	free(p);
+}
+
+void operator delete[](void * p, const nothrow_t &) noexcept {
+	free(p);
+}
+
+#else
+
+long long getThreadAllocationCount() {
+	return 0;
+}
+
+#endif
@@ -0,0 +1,150 @@
+#include "stdafx.h"
+
+using namespace std;
+
+constexpr int BatchedAcrobot::stateDim;
+constexpr int BatchedAcrobot::numActions;
+
+BatchedAcrobot::BatchedAcrobot(const int & numLanes) : numLanes(numLanes) {
+	if (numLanes < 1)
+		throw invalid_argument("BatchedAcrobot needs at least one lane");
+	for (AlignedVector * buffer : { &t, &theta1, &theta2, &theta1Dot, &theta2Dot, &u, &cosS1, &sinS1, &cosPhi1, &cosPhi2 })
+		buffer->resize(numLanes);
+	for (AlignedVector * buffer : { &hilf, &s1, &s2, &s3, &s0_dot, &s1_dot, &s2_dot, &s3_dot })
+		buffer->resize(4 * numLanes);
+	terminal.resize(numLanes);
+	allLanes.assign(numLanes, 1);
+	newEpisode();
+}
+
+int BatchedAcrobot::getNumLanes() const {
+	return numLanes;
+}
+
+int BatchedAcrobot::getStateDim() const {
+	return stateDim;
+}
+
+int BatchedAcrobot::getNumActions() const {
+	return numActions;
+}
+
+// The same operations as Acrobot::update, in the same order, for every lane, with the result kept only in the active lanes.
+void BatchedAcrobot::update(const int * actions, const unsigned char * active, double * rewards) {
+	const double h = dt / integShritte;
+	const int n = 4 * numLanes;
+	for (int k = 0; k < numLanes; k++) {
+		u[k] = (double)(actions[k] - 1)*fmax;
+		hilf[k] = theta1[k];
+		hilf[numLanes + k] = theta2[k];
+		hilf[2 * numLanes + k] = theta1Dot[k];
+		hilf[3 * numLanes + k] = theta2Dot[k];
+	}
+	for (int i = 0; i < integShritte; i++) {
+		f(hilf.data(), u.data(), s0_dot.data());
+		for (int j = 0; j < n; j++)
+			s1[j] = hilf[j] + (h / 2)*s0_dot[j];
+		f(s1.data(), u.data(), s1_dot.data());
+		for (int j = 0; j < n; j++)
+			s2[j] = hilf[j] + (h / 2)*s1_dot[j];
+		f(s2.data(), u.data(), s2_dot.data());
+		for (int j = 0; j < n; j++)
+			s3[j] = hilf[j] + h * s2_dot[j];
+		f(s3.data(), u.data(), s3_dot.data());
+		for (int j = 0; j < n; j++)
+			hilf[j] = hilf[j] + (h / 6) * (s0_dot[j] + 2 * (s1_dot[j] + s2_dot[j]) + s3_dot[j]);
+	}
+	for (int k = 0; k < numLanes; k++) {
+		if (!active[k])
+			continue;
+		double ss[4] = { hilf[k], hilf[numLanes + k], hilf[2 * numLanes + k], hilf[3 * numLanes + k] };
+		if (ss[0] > M_PI)
+			ss[0] -= 2 * M_PI;
+		if (ss[0] < -M_PI)
+			ss[0] += 2 * M_PI;
+		if (ss[1] > M_PI)
+			ss[1] -= 2 * M_PI;
+		if (ss[1] < -M_PI)
+			ss[1] += 2 * M_PI;
+		theta1[k] = wrapPosNegPI(ss[0]);		// Enforce joint angle constraints
+		theta2[k] = wrapPosNegPI(ss[1]);
+		theta1Dot[k] = bound(ss[2], -4 * M_PI, 4 * M_PI);	// Enforce joint angle derivative constraints
+		theta2Dot[k] = bound(ss[3], -9 * M_PI, 9 * M_PI);
+		t[k] += dt;
+	}
+	updateTerminal();
+	for (int k = 0; k < numLanes; k++)
+		rewards[k] = active[k] ? (terminal[k] ? 10 : -.1) : 0.0;
+}
+
+void BatchedAcrobot::update(const int * actions, double * rewards) {
+	update(actions, allLanes.data(), rewards);
+}
+
+void BatchedAcrobot::getStates(double * result) const {
+	State state;
+	for (int k = 0; k < numLanes; k++) {
+		getState(k, state);
+		copy(state.begin(), state.end(), result + k * stateDim);
+	}
+}
+
+void BatchedAcrobot::getState(const int & lane, State & result) const {
+	result[0] = normalize(theta1[lane], -M_PI, M_PI);
+	result[1] = normalize(theta2[lane], -M_PI, M_PI);
+	result[2] = normalize(theta1Dot[lane], -4.0*M_PI, 4.0*M_PI);
+	result[3] = normalize(theta2Dot[lane], -9.0*M_PI, 9.0*M_PI);
+}
+
+const unsigned char * BatchedAcrobot::getTerminalMask() const {
+	return terminal.data();
+}
+
+bool BatchedAcrobot::inTerminalState(const int & lane) const {
+	return terminal[lane] != 0;
+}
+
+void BatchedAcrobot::newEpisode(const unsigned char * reset) {
+	for (int k = 0; k < numLanes; k++) {
+		t[k] = reset[k] ? 0.0 : t[k];
+		theta1[k] = reset[k] ? 0.0 : theta1[k];
+		theta2[k] = reset[k] ? 0.0 : theta2[k];
+		theta1Dot[k] = reset[k] ? 0.0 : theta1Dot[k];
+		theta2Dot[k] = reset[k] ? 0.0 : theta2Dot[k];
+	}
+	updateTerminal();
+}
+
+void BatchedAcrobot::newEpisode() {
+	newEpisode(allLanes.data());
+}
+
+void BatchedAcrobot::f(const double * s, const double * tau, double * buff) {
+	const double * a0 = s, * a1 = s + numLanes, * a2 = s + 2 * numLanes, * a3 = s + 3 * numLanes;
+	for (int k = 0; k < numLanes; k++) {
+		cosS1[k] = cos(a1[k]);
+		sinS1[k] = sin(a1[k]);
+		cosPhi2[k] = cos(a0[k] + a1[k] - M_PI / 2.0);
+		cosPhi1[k] = cos(a0[k] - M_PI / 2.0);
+	}
+	for (int k = 0; k < numLanes; k++) {
+		const double d1 = m1 * lc1*lc1 + m2 * (l1*l1 + lc2 * lc2 + 2 * l1*lc2*cosS1[k]) + i1 + i2;
+		const double d2 = m2 * (lc2*lc2 + l1 * lc2*cosS1[k]) + i2;
+		const double phi2 = (m2*lc2*g*cosPhi2[k]);
+		const double phi1 = (-m2 * l1*lc2*a3[k] * a3[k] * sinS1[k] - 2 * m2*l1*lc2*a3[k] * a2[k] * sinS1[k] + (m1*lc1 + m2 * l1)*g*cosPhi1[k] + phi2);
+		const double newa2 = ((1.0 / (m2*lc2*lc2 + i2 - (d2*d2) / d1)) * (tau[k] + (d2 / d1)*phi1 - m2 * l1*lc2*a2[k] * a2[k] * sinS1[k] - phi2));
+		const double newa1 = ((-1.0 / d1) * (d2*newa2 + phi1));
+		buff[k] = a2[k];
+		buff[numLanes + k] = a3[k];
+		buff[2 * numLanes + k] = newa1;
+		buff[3 * numLanes + k] = newa2;
+	}
+}
+
+void BatchedAcrobot::updateTerminal() {
+	for (int k = 0; k < numLanes; k++) {
+		double elbowY = -l1 * cos(theta1[k]);
+		double handY = elbowY - l2 * cos(theta1[k] + theta2[k]);
+		terminal[k] = handY > l1;
+	}
+}
@@ -0,0 +1,113 @@
+#include "stdafx.h"
+
+using namespace std;
+
+constexpr int BatchedCartPole::stateDim;
+constexpr int BatchedCartPole::numActions;
+
+BatchedCartPole::BatchedCartPole(const int & numLanes) : numLanes(numLanes) {
+	if (numLanes < 1)
+		throw invalid_argument("BatchedCartPole needs at least one lane");
+	for (AlignedVector * buffer : { &x, &v, &theta, &omega, &t, &newX, &newV, &newTheta, &newOmega, &newT, &sinTheta, &cosTheta })
+		buffer->resize(numLanes);
+	terminal.resize(numLanes);
+	allLanes.assign(numLanes, 1);
+	newEpisode();
+}
+
+int BatchedCartPole::getNumLanes() const {
+	return numLanes;
+}
+
+int BatchedCartPole::getStateDim() const {
+	return stateDim;
+}
+
+int BatchedCartPole::getNumActions() const {
+	return numActions;
+}
+
+// The same operations as CartPole::update, in the same order, on copies of the state that are kept only in the active lanes.
+void BatchedCartPole::update(const int * actions, const unsigned char * active, double * rewards) {
+	const double subDt = dt / (double)simSteps;
+	newX = x;
+	newV = v;
+	newTheta = theta;
+	newOmega = omega;
+	newT = t;
+	for (int i = 0; i < simSteps; i++) {
+		for (int k = 0; k < numLanes; k++) {
+			sinTheta[k] = sin(newTheta[k]);
+			cosTheta[k] = cos(newTheta[k]);
+		}
+		for (int k = 0; k < numLanes; k++) {
+			const double F = actions[k]*uMax + (actions[k] - 1)*uMax;
+			const double signV = (double)((newV[k] > 0) - (newV[k] < 0));
+			const double omegaDot = (g*sinTheta[k] + cosTheta[k]*(muc*signV - F - m*l*newOmega[k]*newOmega[k]*sinTheta[k]) / (m + mc) - mup*newOmega[k] / (m*l)) / (l*(4.0 / 3.0 - m / (m + mc)*cosTheta[k]*cosTheta[k]));
+			const double vDot = (F + m*l*(newOmega[k]*newOmega[k]*sinTheta[k] - omegaDot*cosTheta[k]) - muc*signV) / (m + mc);
+			newTheta[k] += subDt*newOmega[k];
+			newOmega[k] += subDt*omegaDot;
+			newX[k] += subDt*newV[k];
+			newV[k] += subDt*vDot;
+			newT[k] += subDt;
+		}
+		for (int k = 0; k < numLanes; k++)
+			newTheta[k] = wrapPosNegPI(newTheta[k]);
+	}
+	for (int k = 0; k < numLanes; k++) {
+		x[k] = active[k] ? min(xMax, max(xMin, newX[k])) : x[k];
+		v[k] = active[k] ? min(vMax, max(vMin, newV[k])) : v[k];
+		theta[k] = active[k] ? min(thetaMax, max(thetaMin, newTheta[k])) : theta[k];
+		omega[k] = active[k] ? min(omegaMax, max(omegaMin, newOmega[k])) : omega[k];
+		t[k] = active[k] ? newT[k] : t[k];
+		rewards[k] = active[k] ? 1.0 : 0.0;
+	}
+	updateTerminal();
+}
+
+void BatchedCartPole::update(const int * actions, double * rewards) {
+	update(actions, allLanes.data(), rewards);
+}
+
+void BatchedCartPole::getStates(double * result) const {
+	State state;
+	for (int k = 0; k < numLanes; k++) {
+		getState(k, state);
+		copy(state.begin(), state.end(), result + k * stateDim);
+	}
+}
+
+void BatchedCartPole::getState(const int & lane, State & result) const {
+	result[0] = normalize(x[lane], xMin, xMax);
+	result[1] = normalize(v[lane], vMin, vMax);
+	result[2] = normalize(theta[lane], thetaMin, thetaMax);
+	result[3] = normalize(omega[lane], omegaMin, omegaMax);
+}
+
+const unsigned char * BatchedCartPole::getTerminalMask() const {
+	return terminal.data();
+}
+
+bool BatchedCartPole::inTerminalState(const int & lane) const {
+	return terminal[lane] != 0;
+}
+
+void BatchedCartPole::newEpisode(const unsigned char * reset) {
+	for (int k = 0; k < numLanes; k++) {
+		x[k] = reset[k] ? 0.0 : x[k];
+		v[k] = reset[k] ? 0.0 : v[k];
+		theta[k] = reset[k] ? 0.0 : theta[k];
+		omega[k] = reset[k] ? 0.0 : omega[k];
+		t[k] = reset[k] ? 0.0 : t[k];
+	}
+	updateTerminal();
+}
+
+void BatchedCartPole::newEpisode() {
+	newEpisode(allLanes.data());
+}
+
+void BatchedCartPole::updateTerminal() {
+	for (int k = 0; k < numLanes; k++)
+		terminal[k] = (fabs(theta[k]) > M_PI / 15.0) || (fabs(x[k]) >= 2.4) || (t[k] >= 20.0 + 10 * dt);
+}
@@ -0,0 +1,89 @@
+#include "stdafx.h"
+
+using namespace std;
+
+constexpr int BatchedMountainCar::stateDim;
+constexpr int BatchedMountainCar::numActions;
+
+BatchedMountainCar::BatchedMountainCar(const int & numLanes) : numLanes(numLanes) {
+	if (numLanes < 1)
+		throw invalid_argument("BatchedMountainCar needs at least one lane");
+	x.resize(numLanes);
+	xDot.resize(numLanes);
+	slope.resize(numLanes);
+	terminal.resize(numLanes);
+	allLanes.assign(numLanes, 1);
+	newEpisode();
+}
+
+int BatchedMountainCar::getNumLanes() const {
+	return numLanes;
+}
+
+int BatchedMountainCar::getStateDim() const {
+	return stateDim;
+}
+
+int BatchedMountainCar::getNumActions() const {
+	return numActions;
+}
+
+void BatchedMountainCar::update(const int * actions, const unsigned char * active, double * rewards) {
+	for (int l = 0; l < numLanes; l++)
+		slope[l] = cos(3.0*x[l]);
+	// The same operations as MountainCar::update, in the same order, with the branches written as selects.
+	for (int l = 0; l < numLanes; l++) {
+		const double u = (double)actions[l] - 1.0;
+		double newXDot = min(maxXDot, max(minXDot, xDot[l] + 0.001*u - 0.0025*slope[l]));
+		double newX = x[l] + newXDot;
+		newXDot = (newX < minX) ? 0.0 : newXDot;
+		newX = (newX < minX) ? minX : newX;
+		newX = (newX > maxX) ? maxX : newX;
+		x[l] = active[l] ? newX : x[l];
+		xDot[l] = active[l] ? newXDot : xDot[l];
+		rewards[l] = active[l] ? -1.0 : 0.0;
+	}
+	updateTerminal();
+}
+
+void BatchedMountainCar::update(const int * actions, double * rewards) {
+	update(actions, allLanes.data(), rewards);
+}
+
+void BatchedMountainCar::getStates(double * result) const {
+	State state;
+	for (int k = 0; k < numLanes; k++) {
+		getState(k, state);
+		copy(state.begin(), state.end(), result + k * stateDim);
+	}
+}
+
+void BatchedMountainCar::getState(const int & lane, State & result) const {
+	result[0] = normalize(x[lane], minX, maxX);
+	result[1] = normalize(xDot[lane], minXDot, maxXDot);
+}
+
+const unsigned char * BatchedMountainCar::getTerminalMask() const {
+	return terminal.data();
+}
+
+bool BatchedMountainCar::inTerminalState(const int & lane) const {
+	return terminal[lane] != 0;
+}
+
+void BatchedMountainCar::newEpisode(const unsigned char * reset) {
+	for (int l = 0; l < numLanes; l++) {
+		x[l] = reset[l] ? -0.5 : x[l];
+		xDot[l] = reset[l] ? 0.0 : xDot[l];
+	}
+	updateTerminal();
+}
+
+void BatchedMountainCar::newEpisode() {
+	newEpisode(allLanes.data());
+}
+
+void BatchedMountainCar::updateTerminal() {
+	for (int l = 0; l < numLanes; l++)
+		terminal[l] = x[l] >= maxX;
+}
@@ -0,0 +1,1063 @@
+#include "stdafx.h"
+
+using namespace std;
+
+// Results of the timed loops are written here so that the compiler cannot remove the loops
+static volatile double benchmarkSink;
+
+// Seconds elapsed since start
+static double secondsSince(const chrono::steady_clock::time_point & start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Name of a coefficient layout, for the csv output.
+static const char * layoutName(const CoefficientLayout & layout) {
+	return (layout == CoefficientLayout::Dense) ? "dense" : ((layout == CoefficientLayout::Sparse) ? "sparse" : "implicit");
+}
+
+// Random states with every element in [0,1], like the normalized states the environments return.
+static vector<vector<double>> randomStates(const int & numStates, const int & stateDim, mt19937_64 & generator) {
+	uniform_real_distribution<double> d(0.0, 1.0);
+	vector<vector<double>> result(numStates, vector<double>(stateDim));
+	for (int n = 0; n < numStates; n++)
+		for (int k = 0; k < stateDim; k++)
+			result[n][k] = d(generator);
+	return result;
+}
+
+// States visited by running a uniform-random policy in the environment e.
+template <typename Environment>
+vector<vector<double>> visitedStates(Environment & e, const int & numStates, mt19937_64 & generator) {
+	uniform_int_distribution<int> action(0, e.getNumActions() - 1);
+	vector<vector<double>> result(numStates);
+	e.newEpisode(generator);
+	for (int n = 0; n < numStates; n++) {
+		if (e.inTerminalState())
+			e.newEpisode(generator);
+		result[n] = e.getState(generator);
+		e.update(action(generator), generator);
+	}
+	return result;
+}
+
+// The original FourierBasis: one heap-allocated coefficient row per term and one dot product per term. Kept here as the baseline.
+class LegacyFourierBasis {
+public:
+	void init(const int & inputDimension, int iOrder, int dOrder) {
+		int dTerms = ipow(dOrder + 1, inputDimension);
+		vector<double> counter(inputDimension, 0.0);
+		c.clear();
+		for (int t = 0; t < dTerms; t++) {
+			c.push_back(counter);
+			incrementCounter(counter, dOrder);
+		}
+		for (int i = 0; i < inputDimension; i++) {
+			for (int j = dOrder + 1; j <= iOrder; j++) {
+				c.push_back(vector<double>(inputDimension, 0.0));
+				c.back()[i] = (double)j;
+			}
+		}
+	}
+	vector<double> basify(const vector<double> & x) const {
+		vector<double> result(c.size());
+		for (int i = 0; i < (int)c.size(); i++)
+			result[i] = cos(M_PI*dot(c[i], x));
+		return result;
+	}
+
+private:
+	vector<vector<double>> c;
+};
+
+bool runBenchmark(const string & name) {
+	if (name == "basify")
+		benchmarkBasify();
+	else if (name == "cosine")
+		benchmarkCosine();
+	else if (name == "harmonics")
+		benchmarkHarmonics();
+	else if (name == "sparse")
+		benchmarkSparse();
+	else if (name == "weights")
+		benchmarkWeights();
+	else if (name == "static")
+		benchmarkStatic();
+	else if (name == "batch")
+		benchmarkBatch();
+	else if (name == "implicit")
+		benchmarkImplicit();
+	else if (name == "incremental")
+		benchmarkIncremental();
+	else if (name == "featurecache")
+		benchmarkFeatureCache();
+	else if (name == "tiles")
+		benchmarkTileCoding();
+	else if (name == "sparsestate")
+		benchmarkSparseState();
+	else if (name == "tabular")
+		benchmarkTabular();
+	else if (name == "gridmap")
+		benchmarkGridMap();
+	else if (name == "batched")
+		benchmarkBatchedEnvironments();
+	else if (name == "lockstep")
+		benchmarkLockstep();
+	else if (name == "sweep")
+		benchmarkSweep();
+	else if (name == "scheduler")
+		benchmarkScheduler();
+	else if (name == "sweepengine")
+		benchmarkSweepEngine();
+	else
+		return false;
+	return true;
+}
+
+void benchmarkBasify() {
+	mt19937_64 generator(0);
+	const int numStates = 256;		// Cycle through this many states, so the inputs are not all in cache as a single vector
+	const double minTerms = 2e6;	// Evaluate at least this many terms per configuration and implementation
+	cout << "stateDim,iOrder,dOrder,nTerms,legacy terms/sec,basify terms/sec,speedup,max abs difference" << endl;
+	for (int stateDim : {2, 4}) {
+		vector<vector<double>> states = randomStates(numStates, stateDim, generator);
+		for (int iOrder = 1; iOrder <= 9; iOrder++) {
+			for (int dOrder = 0; dOrder <= 3; dOrder++) {
+				LegacyFourierBasis legacy;
+				FourierBasis fb;
+				legacy.init(stateDim, iOrder, dOrder);
+				fb.init(stateDim, iOrder, dOrder);
+				const int nTerms = fb.getNumOutputs();
+				const int numCalls = max(numStates, (int)(minTerms / nTerms));
+				double checksum = 0, maxDiff = 0;
+
+				chrono::steady_clock::time_point start = chrono::steady_clock::now();
+				for (int n = 0; n < numCalls; n++)
+					checksum += legacy.basify(states[n % numStates])[n % nTerms];
+				double legacyRate = (double)numCalls * nTerms / secondsSince(start);
+
+				vector<double> features;
+				start = chrono::steady_clock::now();
+				for (int n = 0; n < numCalls; n++) {
+					fb.basify(states[n % numStates], features);
+					checksum += features[n % nTerms];
+				}
+				double newRate = (double)numCalls * nTerms / secondsSince(start);
+
+				for (int n = 0; n < numStates; n++) {
+					vector<double> a = legacy.basify(states[n]), b = fb.basify(states[n]);
+					for (int i = 0; i < nTerms; i++)
+						maxDiff = max(maxDiff, fabs(a[i] - b[i]));
+				}
+				cout << stateDim << "," << iOrder << "," << dOrder << "," << nTerms << "," << legacyRate << "," << newRate << ","
+					<< newRate / legacyRate << "," << maxDiff << endl;
+				benchmarkSink = checksum;
+			}
+		}
+	}
+}
+
+// Error of approx in units in the last place of the exact value, exact being cos(pi*t) evaluated in long double after an exact reduction
+// of t (as sin(pi*(1/2-|r|)), so that the zeros at t = 1/2 + k are exactly zero).
+static double ulpError(const double & approx, const double & t) {
+	const long double piL = 3.141592653589793238462643383279502884L;
+	long double r = (long double)t - 2.0L * nearbyintl(0.5L * (long double)t);
+	long double exact = sinl(piL * (0.5L - fabsl(r)));
+	double e = fabs((double)exact);
+	double ulp = nextafter(e, INFINITY) - e;
+	return (double)(fabsl((long double)approx - exact) / (long double)ulp);
+}
+
+void benchmarkCosine() {
+	mt19937_64 generator(0);
+	const int n = 4096, reps = 2000;
+	cout << "SIMD level detected: " << simdLevelName(getSimdLevel()) << endl;
+	cout << "range,mode,level,cos/sec,max ulp error,max abs difference from Exact,identical to Fast scalar" << endl;
+	for (double maxT : {1.0, 9.0, 36.0}) {	// Largest argument of an independent term at iOrder 9 is 9, and of a dOrder 9 coupled term on a 4-D state is 36
+		vector<double> t(n), exact(n), fastScalar(n), out(n);
+		uniform_real_distribution<double> d(0.0, maxT);
+		for (int i = 0; i < n; i++)
+			t[i] = d(generator);
+		cosPi(t.data(), exact.data(), n, CosineMode::Exact);
+		cosPi(t.data(), fastScalar.data(), n, CosineMode::Fast, SimdLevel::Scalar);
+		vector<pair<CosineMode, SimdLevel>> runs = { { CosineMode::Exact, SimdLevel::Scalar }, { CosineMode::Fast, SimdLevel::Scalar } };
+		if (getSimdLevel() >= SimdLevel::AVX2)
+			runs.push_back({ CosineMode::Fast, SimdLevel::AVX2 });
+		if (getSimdLevel() >= SimdLevel::AVX512)
+			runs.push_back({ CosineMode::Fast, SimdLevel::AVX512 });
+		for (const pair<CosineMode, SimdLevel> & run : runs) {
+			double checksum = 0;
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			for (int rep = 0; rep < reps; rep++) {
+				cosPi(t.data(), out.data(), n, run.first, run.second);
+				checksum += out[rep % n];
+			}
+			double rate = (double)n * reps / secondsSince(start);
+			benchmarkSink = checksum;
+			double maxUlp = 0, maxDiff = 0;
+			bool identical = true;
+			for (int i = 0; i < n; i++) {
+				maxUlp = max(maxUlp, ulpError(out[i], t[i]));
+				maxDiff = max(maxDiff, fabs(out[i] - exact[i]));
+				identical = identical && (out[i] == fastScalar[i]);
+			}
+			cout << "[0," << maxT << "]," << (run.first == CosineMode::Exact ? "Exact" : "Fast") << "," << simdLevelName(run.first == CosineMode::Exact ? SimdLevel::Scalar : run.second) << ","
+				<< rate << "," << maxUlp << "," << maxDiff << "," << (identical ? "yes" : "no") << endl;
+		}
+	}
+}
+
+void benchmarkHarmonics() {
+	mt19937_64 generator(0);
+	const int stateDim = 4, numStates = 256, numCalls = 200000;
+	vector<vector<double>> states = randomStates(numStates, stateDim, generator);
+	cout << "stateDim,iOrder,dOrder,mode,cosines direct,cosines recurrence,terms/sec direct,terms/sec recurrence,speedup,max abs error" << endl;
+	for (CosineMode mode : { CosineMode::Exact, CosineMode::Fast }) {
+		for (int dOrder = 0; dOrder <= 1; dOrder++) {
+			for (int iOrder = 1; iOrder <= 9; iOrder++) {
+				FourierBasis direct, recurrence;
+				direct.init(stateDim, iOrder, dOrder);
+				recurrence.init(stateDim, iOrder, dOrder);
+				direct.setCosineMode(mode);
+				recurrence.setCosineMode(mode);
+				recurrence.setHarmonicRecurrence(true);
+				const int nTerms = direct.getNumOutputs();
+				vector<double> a, b;
+				double rates[2], checksum = 0, maxDiff = 0;
+				for (int run = 0; run < 2; run++) {
+					const FourierBasis & fb = (run == 0) ? direct : recurrence;
+					chrono::steady_clock::time_point start = chrono::steady_clock::now();
+					for (int n = 0; n < numCalls; n++) {
+						fb.basify(states[n % numStates], a);
+						checksum += a[n % nTerms];
+					}
+					rates[run] = (double)numCalls * nTerms / secondsSince(start);
+				}
+				benchmarkSink = checksum;
+				for (int n = 0; n < numStates; n++) {
+					direct.basify(states[n], a);
+					recurrence.basify(states[n], b);
+					for (int i = 0; i < nTerms; i++)
+						maxDiff = max(maxDiff, fabs(a[i] - b[i]));
+				}
+				cout << stateDim << "," << iOrder << "," << dOrder << "," << (mode == CosineMode::Exact ? "Exact" : "Fast") << ","
+					<< direct.getNumCosineEvaluations() << "," << recurrence.getNumCosineEvaluations() << "," << rates[0] << "," << rates[1] << ","
+					<< rates[1] / rates[0] << "," << maxDiff << endl;
+			}
+		}
+	}
+}
+
+void benchmarkSparse() {
+	mt19937_64 generator(0);
+	const int numStates = 256;
+	const double minTerms = 4e6;
+	Gridworld gridworld;
+	Acrobot acrobot;
+	vector<vector<double>> gridworldStates = visitedStates(gridworld, numStates, generator), acrobotStates = visitedStates(acrobot, numStates, generator);
+	cout << "environment,stateDim,iOrder,dOrder,nTerms,nonzeros,default layout,mode,dense ns/feature,sparse ns/feature,speedup" << endl;
+	for (int env = 0; env < 2; env++) {
+		const vector<vector<double>> & states = (env == 0) ? gridworldStates : acrobotStates;
+		const int stateDim = (int)states[0].size();
+		for (int dOrder = 0; dOrder <= ((env == 0) ? 0 : 2); dOrder++) {
+			for (int iOrder = 1; iOrder <= ((env == 0) ? 4 : 9); iOrder += ((env == 0) ? 1 : 2)) {
+				for (CosineMode mode : { CosineMode::Exact, CosineMode::Fast }) {
+					FourierBasis fb;
+					fb.init(stateDim, iOrder, dOrder);
+					fb.setCosineMode(mode);
+					const CoefficientLayout defaultLayout = fb.getCoefficientLayout();
+					const int nTerms = fb.getNumOutputs(), numCalls = max(numStates, (int)(minTerms / nTerms));
+					double nsPerFeature[2], checksum = 0;
+					vector<double> features;
+					for (int run = 0; run < 2; run++) {
+						fb.setCoefficientLayout((run == 0) ? CoefficientLayout::Dense : CoefficientLayout::Sparse);
+						chrono::steady_clock::time_point start = chrono::steady_clock::now();
+						for (int n = 0; n < numCalls; n++) {
+							fb.basify(states[n % numStates], features);
+							checksum += features[n % nTerms];
+						}
+						nsPerFeature[run] = 1e9 * secondsSince(start) / ((double)numCalls * nTerms);
+					}
+					benchmarkSink = checksum;
+					cout << ((env == 0) ? "Gridworld" : "Acrobot") << "," << stateDim << "," << iOrder << "," << dOrder << "," << nTerms << ","
+						<< fb.getNumNonzeros() << "," << layoutName(defaultLayout) << ","
+						<< ((mode == CosineMode::Exact) ? "Exact" : "Fast") << "," << nsPerFeature[0] << "," << nsPerFeature[1] << ","
+						<< nsPerFeature[0] / nsPerFeature[1] << endl;
+				}
+			}
+		}
+	}
+}
+
+void benchmarkWeights() {
+	mt19937_64 generator(0);
+	uniform_real_distribution<double> d(-1.0, 1.0);
+	const int numActions = 3, numPhis = 64;
+	const double minProducts = 2e8;		// Multiply-adds per implementation and size
+	cout << "SIMD level detected: " << simdLevelName(getSimdLevel()) << endl;
+	cout << "numFeatures,vector-of-rows ns/step,WeightMatrix ns/step,speedup,max abs q difference" << endl;
+	for (int numFeatures : { 16, 81, 256, 1000, 4096, 16384 }) {
+		vector<vector<double>> phis(numPhis, vector<double>(numFeatures));
+		for (vector<double> & phi : phis)
+			for (double & f : phi)
+				f = d(generator);
+		vector<vector<double>> rows(numActions, vector<double>(numFeatures, 0.0));
+		WeightMatrix w(numActions, numFeatures);
+		const int numSteps = max(numPhis, (int)(minProducts / ((numActions + 1.0) * numFeatures)));
+		double ns[2], checksum = 0, maxDiff = 0;
+		for (int run = 0; run < 2; run++) {
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			for (int n = 0; n < numSteps; n++) {
+				const vector<double> & phi = phis[n % numPhis];
+				const int a = n % numActions;
+				double q[numActions];
+				for (int b = 0; b < numActions; b++)
+					q[b] = (run == 0) ? dot(rows[b], phi) : w.dot(b, phi);
+				const double step = 1e-3 * (1.0 - q[a]) / numFeatures;	// A small, stable update toward q = 1
+				if (run == 0) {
+					for (int i = 0; i < numFeatures; i++)
+						rows[a][i] += step * phi[i];
+				}
+				else
+					w.addScaled(a, step, phi);
+				checksum += q[a];
+			}
+			ns[run] = 1e9 * secondsSince(start) / numSteps;
+		}
+		benchmarkSink = checksum;
+		for (const vector<double> & phi : phis)
+			for (int b = 0; b < numActions; b++)
+				maxDiff = max(maxDiff, fabs(dot(rows[b], phi) - w.dot(b, phi)));
+		cout << numFeatures << "," << ns[0] << "," << ns[1] << "," << ns[0] / ns[1] << "," << maxDiff << endl;
+	}
+}
+
+// One row of benchmarkStatic, for the configuration (StateDim, IOrder, DOrder).
+template <int StateDim, int IOrder, int DOrder>
+static void benchmarkStaticConfig(const CosineMode & mode, mt19937_64 & generator) {
+	typedef StaticFourierBasis<StateDim, IOrder, DOrder> Basis;
+	const int numStates = 256, numActions = 3, numCalls = 2000000;
+	vector<vector<double>> states = randomStates(numStates, StateDim, generator);
+	FourierBasis fb;
+	Basis sb;
+	fb.init(StateDim, IOrder, DOrder);
+	fb.setCosineMode(mode);
+	sb.setCosineMode(mode);
+	WeightMatrix w(numActions, Basis::numTerms);
+	uniform_real_distribution<double> d(-1.0, 1.0);
+	for (int a = 0; a < numActions; a++)
+		for (int i = 0; i < Basis::numTerms; i++)
+			w.row(a)[i] = d(generator);
+	vector<double> phi;
+	typename Basis::Features features;
+	QValues q1, q2;
+	double ns[2], checksum = 0;
+	bool identical = true;
+	for (int run = 0; run < 2; run++) {
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int n = 0; n < numCalls; n++) {
+			const vector<double> & s = states[n % numStates];
+			if (run == 0) {
+				fb.basify(s, phi);
+				computeQValues(phi, w, q1);
+			}
+			else {
+				sb.basify(s.data(), features);
+				for (int a = 0; a < numActions; a++)
+					q2[a] = dotProduct<Basis::numTerms>(w.row(a), features.data());
+			}
+			checksum += (run == 0) ? q1[n % numActions] : q2[n % numActions];
+		}
+		ns[run] = 1e9 * secondsSince(start) / numCalls;
+	}
+	benchmarkSink = checksum;
+	for (const vector<double> & s : states) {
+		fb.basify(s, phi);
+		sb.basify(s.data(), features);
+		identical = identical && equal(phi.begin(), phi.end(), features.begin());
+	}
+	cout << StateDim << "," << IOrder << "," << DOrder << "," << Basis::numTerms << "," << ((mode == CosineMode::Exact) ? "Exact" : "Fast") << ","
+		<< ns[0] << "," << ns[1] << "," << ns[0] / ns[1] << "," << (identical ? "yes" : "no") << endl;
+}
+
+// Calls benchmarkStaticConfig for every configuration in a BasisConfigList.
+template <typename List> struct StaticBenchmarkRunner;
+template <> struct StaticBenchmarkRunner<BasisConfigList<>> {
+	static void run(const CosineMode &, mt19937_64 &) {}
+};
+template <int S, int I, int D, typename... Rest> struct StaticBenchmarkRunner<BasisConfigList<BasisConfig<S, I, D>, Rest...>> {
+	static void run(const CosineMode & mode, mt19937_64 & generator) {
+		benchmarkStaticConfig<S, I, D>(mode, generator);
+		StaticBenchmarkRunner<BasisConfigList<Rest...>>::run(mode, generator);
+	}
+};
+
+void benchmarkStatic() {
+	mt19937_64 generator(0);
+	cout << "stateDim,iOrder,dOrder,nTerms,mode,dynamic ns/state,static ns/state,speedup,identical features" << endl;
+	for (CosineMode mode : { CosineMode::Exact, CosineMode::Fast })
+		StaticBenchmarkRunner<PrebuiltBasisConfigs>::run(mode, generator);
+}
+
+void benchmarkBatch() {
+	mt19937_64 generator(0);
+	const int numStates = 4096;
+	const double minTerms = 5e7;
+	cout << "stateDim,iOrder,dOrder,nTerms,layout,mode,loop states/sec,batch states/sec,speedup,identical" << endl;
+	for (int stateDim : { 2, 4, 8 }) {
+		vector<vector<double>> rows = randomStates(numStates, stateDim, generator);
+		vector<double> states;
+		for (const vector<double> & row : rows)
+			states.insert(states.end(), row.begin(), row.end());
+		for (const pair<int, int> & orders : { make_pair(3, 0), make_pair(9, 1), make_pair(3, 3) }) {
+			if ((stateDim == 8) && (orders.second == 3))
+				continue;	// 4^8 terms per state is too large for a 4096-state batch
+			for (CosineMode mode : { CosineMode::Exact, CosineMode::Fast }) {
+				for (CoefficientLayout layout : { CoefficientLayout::Dense, CoefficientLayout::Sparse }) {
+					FourierBasis fb;
+					fb.init(stateDim, orders.first, orders.second);
+					fb.setCosineMode(mode);
+					fb.setCoefficientLayout(layout);
+					const int nTerms = fb.getNumOutputs();
+					const int reps = max(1, (int)(minTerms / ((double)numStates * nTerms)));
+					vector<double> loopFeatures((size_t)numStates * nTerms), batchFeatures, phi;
+					double rates[2], checksum = 0;
+					for (int run = 0; run < 2; run++) {
+						chrono::steady_clock::time_point start = chrono::steady_clock::now();
+						for (int rep = 0; rep < reps; rep++) {
+							if (run == 0) {
+								for (int n = 0; n < numStates; n++) {
+									fb.basify(rows[n], phi);
+									copy(phi.begin(), phi.end(), loopFeatures.begin() + (size_t)n * nTerms);
+								}
+							}
+							else
+								fb.basifyBatch(states, batchFeatures);
+							checksum += (run == 0) ? loopFeatures[rep % loopFeatures.size()] : batchFeatures[rep % batchFeatures.size()];
+						}
+						rates[run] = (double)numStates * reps / secondsSince(start);
+					}
+					benchmarkSink = checksum;
+					cout << stateDim << "," << orders.first << "," << orders.second << "," << nTerms << "," << layoutName(layout) << ","
+						<< ((mode == CosineMode::Exact) ? "Exact" : "Fast") << "," << rates[0] << "," << rates[1] << "," << rates[1] / rates[0] << ","
+						<< ((loopFeatures == batchFeatures) ? "yes" : "no") << endl;
+				}
+			}
+		}
+	}
+}
+
+void benchmarkImplicit() {
+	mt19937_64 generator(0);
+	const int numStates = 256;
+	const double minTerms = 2e7;
+	cout << "stateDim,iOrder,dOrder,nTerms,layout,coefficient bytes,ns/feature,max diff from sparse" << endl;
+	for (int stateDim : { 4, 6, 8 }) {
+		const vector<vector<double>> states = randomStates(numStates, stateDim, generator);
+		for (int dOrder : { 2, 3 }) {
+			const long long dTerms = FourierBasis::countCoupledTerms(stateDim, dOrder);
+			if (dTerms > (1 << 16))
+				continue;
+			FourierBasis fb;
+			fb.init(stateDim, dOrder, dOrder, (int)dTerms);
+			const int nTerms = fb.getNumOutputs(), numCalls = max(8, (int)(minTerms / nTerms));
+			vector<vector<double>> reference(numStates);
+			fb.setCoefficientLayout(CoefficientLayout::Sparse);
+			for (int n = 0; n < numStates; n++)
+				fb.basify(states[n], reference[n]);
+			for (int run = 0; run < 3; run++) {
+				const CoefficientLayout layout = (run == 0) ? CoefficientLayout::Dense : ((run == 1) ? CoefficientLayout::Sparse : CoefficientLayout::Implicit);
+				fb.setCoefficientLayout(layout);
+				vector<double> features;
+				double checksum = 0, maxDiff = 0;
+				chrono::steady_clock::time_point start = chrono::steady_clock::now();
+				for (int n = 0; n < numCalls; n++) {
+					fb.basify(states[n % numStates], features);
+					checksum += features[n % nTerms];
+				}
+				const double nsPerFeature = 1e9 * secondsSince(start) / ((double)numCalls * nTerms);
+				benchmarkSink = checksum;
+				for (int n = 0; n < numStates; n++) {
+					fb.basify(states[n], features);
+					for (int i = 0; i < nTerms; i++)
+						maxDiff = max(maxDiff, fabs(features[i] - reference[n][i]));
+				}
+				cout << stateDim << "," << dOrder << "," << dOrder << "," << nTerms << "," << layoutName(layout) << "," << fb.getCoefficientMemory() << ","
+					<< nsPerFeature << "," << maxDiff << endl;
+			}
+		}
+	}
+}
+
+// Time per step of basify and of IncrementalFeatures::update along a trajectory, and the largest difference between the two.
+template <typename Environment>
+static void benchmarkIncrementalOn(const char * name, const int & iOrder, const int & dOrder, mt19937_64 & generator) {
+	const int numStates = 20000;
+	Environment e;
+	const vector<vector<double>> states = visitedStates(e, numStates, generator);
+	shared_ptr<FourierBasis> basis = make_shared<FourierBasis>();
+	basis->init(e.getStateDim(), iOrder, dOrder);
+	IncrementalFeatures incremental(basis);
+	vector<double> features;
+	double seconds[2], checksum = 0, maxDiff = 0;
+	for (int run = 0; run < 2; run++) {
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int n = 0; n < numStates; n++) {
+			if (run == 0)
+				basis->basify(states[n], features);
+			checksum += (run == 0) ? features[n % features.size()] : incremental.update(states[n])[n % features.size()];
+		}
+		seconds[run] = secondsSince(start);
+	}
+	benchmarkSink = checksum;
+	incremental.invalidate();
+	for (int n = 0; n < numStates; n++) {
+		const vector<double> & phi = incremental.update(states[n]);
+		basis->basify(states[n], features);
+		for (size_t i = 0; i < features.size(); i++)
+			maxDiff = max(maxDiff, fabs(phi[i] - features[i]));
+	}
+	const double fullFraction = (double)incremental.getNumFullUpdates() / (double)(incremental.getNumFullUpdates() + incremental.getNumIncrementalUpdates());
+	cout << name << "," << e.getStateDim() << "," << iOrder << "," << dOrder << "," << basis->getNumOutputs() << "," << 1e9 * seconds[0] / numStates << ","
+		<< 1e9 * seconds[1] / numStates << "," << seconds[0] / seconds[1] << "," << fullFraction << "," << maxDiff << endl;
+}
+
+void benchmarkIncremental() {
+	mt19937_64 generator(0);
+	cout << "environment,stateDim,iOrder,dOrder,nTerms,basify ns/step,incremental ns/step,speedup,fraction recomputed,max diff" << endl;
+	for (int iOrder : { 1, 4, 8 })
+		benchmarkIncrementalOn<Gridworld>("Gridworld", iOrder, 0, generator);
+	for (const pair<int, int> & orders : { make_pair(3, 3), make_pair(7, 7) })
+		benchmarkIncrementalOn<MountainCar>("MountainCar", orders.first, orders.second, generator);
+	for (const pair<int, int> & orders : { make_pair(4, 0), make_pair(3, 3) }) {
+		benchmarkIncrementalOn<CartPole>("CartPole", orders.first, orders.second, generator);
+		benchmarkIncrementalOn<Acrobot>("Acrobot", orders.first, orders.second, generator);
+	}
+}
+
+// Time per lookup, hit rate and error of a FeatureCache along a trajectory, against basify.
+template <typename Environment>
+static void benchmarkFeatureCacheOn(const char * name, const int & iOrder, const int & dOrder, const int & capacity, const vector<double> & cellSize, mt19937_64 & generator) {
+	const int numStates = 200000;
+	Environment e;
+	const vector<vector<double>> states = visitedStates(e, numStates, generator);
+	shared_ptr<FourierBasis> basis = make_shared<FourierBasis>();
+	basis->init(e.getStateDim(), iOrder, dOrder);
+	FeatureCache cache(basis, capacity, cellSize);
+	vector<double> features, cached;
+	double seconds[2], checksum = 0, maxDiff = 0;
+	for (int run = 0; run < 2; run++) {
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int n = 0; n < numStates; n++) {
+			if (run == 0)
+				basis->basify(states[n], features);
+			else
+				cache.basify(states[n], features);
+			checksum += features[n % features.size()];
+		}
+		seconds[run] = secondsSince(start);
+	}
+	benchmarkSink = checksum;
+	for (int n = 0; n < numStates; n += 97) {
+		basis->basify(states[n], features);
+		cache.basify(states[n], cached);
+		for (size_t i = 0; i < features.size(); i++)
+			maxDiff = max(maxDiff, fabs(cached[i] - features[i]));
+	}
+	const double lookups = (double)(cache.getNumHits() + cache.getNumMisses());
+	cout << name << "," << basis->getNumOutputs() << "," << capacity << "," << (cellSize.empty() ? 0.0 : cellSize[0]) << "," << cache.getMemory() << ","
+		<< 1e9 * seconds[0] / numStates << "," << 1e9 * seconds[1] / numStates << "," << seconds[0] / seconds[1] << "," << cache.getNumHits() / lookups << ","
+		<< cache.getNumMisses() << "," << cache.getNumEvictions() << "," << maxDiff << endl;
+}
+
+void benchmarkFeatureCache() {
+	mt19937_64 generator(0);
+	cout << "environment,nTerms,capacity,first cell width,bytes,basify ns/state,cache ns/state,speedup,hit rate,misses,evictions,max diff" << endl;
+	for (int capacity : { 64, 16 })
+		benchmarkFeatureCacheOn<Gridworld>("Gridworld", 4, 0, capacity, vector<double>(), generator);
+	benchmarkFeatureCacheOn<MountainCar>("MountainCar", 7, 7, 4096, vector<double>(), generator);
+	for (double width : { 0.01, 0.001 }) {
+		// Cells of width `width` on the normalized state, which MountainCar returns in [0, 1]
+		benchmarkFeatureCacheOn<MountainCar>("MountainCar", 7, 7, 4096, vector<double>(2, width), generator);
+		benchmarkFeatureCacheOn<MountainCar>("MountainCar", 7, 7, 65536, vector<double>(2, width), generator);
+	}
+}
+
+// Run numEpisodes episodes of agent on a fresh environment, printing the time per step and the return of the last episode.
+template <typename Agent, typename Environment>
+static void benchmarkAgentSteps(const char * name, const char * features, Agent agent, const int & numFeatures, const int & numEpisodes, const int & maxEpisodeLength) {
+	Environment e;
+	mt19937_64 generator(0);
+	typename ObservationType<Agent, Environment>::type state, nextState;
+	long long numSteps = 0;
+	double lastReturn = 0;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (int episode = 0; episode < numEpisodes; episode++) {
+		e.newEpisode(generator);
+		agent.newEpisode(generator);
+		e.getState(generator, state);
+		lastReturn = 0;
+		bool inTerminalState = false;
+		for (int t = 0; (t < maxEpisodeLength) && (!inTerminalState); t++) {
+			const int action = agent.getAction(state, generator);
+			double reward = e.update(action, generator);
+			lastReturn += reward;
+			e.getState(generator, nextState);
+			inTerminalState = e.inTerminalState();
+			agent.train(generator, state, action, reward, nextState, inTerminalState);
+			swap(state, nextState);
+			numSteps++;
+		}
+	}
+	cout << name << "," << features << "," << numFeatures << "," << 1e9 * secondsSince(start) / numSteps << "," << lastReturn << endl;
+}
+
+void benchmarkTileCoding() {
+	const int numEpisodes = 50;
+	cout << "agent,features,numFeatures,ns/step,last return" << endl;
+	for (int order : { 3, 7 }) {
+		const int numFeatures = fourierNumTerms(2, order, order);
+		const string features = "Fourier " + to_string(order) + "/" + to_string(order);
+		benchmarkAgentSteps<QLearning, MountainCar>("QLearning", features.c_str(), QLearning(2, 3, 0.005, 1.0, 0.0, order, order), numFeatures, numEpisodes, 20000);
+		benchmarkAgentSteps<Sarsa, MountainCar>("Sarsa", features.c_str(), Sarsa(2, 3, 0.005, 1.0, 0.0, order, order), numFeatures, numEpisodes, 20000);
+	}
+	for (int tiles : { 8, 32 }) {
+		const int numTilings = 8;
+		TileCoding tc;
+		tc.init(2, numTilings, tiles);
+		const string features = to_string(numTilings) + " tilings of " + to_string(tiles) + "x" + to_string(tiles);
+		benchmarkAgentSteps<TileCodingQLearning, MountainCar>("TileCodingQLearning", features.c_str(), TileCodingQLearning(2, 3, 0.5 / numTilings, 1.0, 0.0, numTilings, tiles), tc.getNumOutputs(), numEpisodes, 20000);
+		benchmarkAgentSteps<TileCodingSarsa, MountainCar>("TileCodingSarsa", features.c_str(), TileCodingSarsa(2, 3, 0.5 / numTilings, 1.0, 0.0, numTilings, tiles), tc.getNumOutputs(), numEpisodes, 20000);
+	}
+}
+
+// Time per step of agent on one-hot states of dimension stateDim passed as std::vector<double> and as SparseState, on the same
+// transitions (a uniform random walk over the states, with random actions, in episodes of episodeLength steps), and the largest
+// difference between q(s,a) from WeightMatrix and from ShiftedWeightMatrix after the same updates with dense and sparse features.
+template <typename Agent>
+static void benchmarkSparseStateOn(const char * name, const int & stateDim, const int & iOrder) {
+	const int numSteps = 40000, episodeLength = 200, numActions = 4;
+	mt19937_64 generator(0);
+	uniform_int_distribution<int> nextState(0, stateDim - 1), nextAction(0, numActions - 1);
+	vector<int> index(numSteps + 1), action(numSteps);
+	for (int t = 0; t < numSteps; t++) {
+		index[t] = nextState(generator);
+		action[t] = nextAction(generator);
+	}
+	index[numSteps] = nextState(generator);
+	double seconds[2];
+	for (int run = 0; run < 2; run++) {
+		Agent agent(stateDim, numActions, 0.1, 1.0, 0.1, iOrder, 0);
+		mt19937_64 agentGenerator(1);
+		vector<double> denseS, denseSPrime;
+		SparseState sparseS, sparseSPrime;
+		long long checksum = 0;
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int t = 0; t < numSteps; t++) {
+			double reward = -1;
+			const bool terminal = ((t + 1) % episodeLength == 0);
+			if (run == 0) {		// Build the states the way Gridworld::getState does
+				denseS.assign(stateDim, 0.0);
+				denseS[index[t]] = 1.0;
+				denseSPrime.assign(stateDim, 0.0);
+				denseSPrime[index[t + 1]] = 1.0;
+				checksum += agent.getAction(denseS, agentGenerator);
+				agent.train(agentGenerator, denseS, action[t], reward, denseSPrime, terminal);
+			}
+			else {
+				sparseS.setOneHot(stateDim, index[t]);
+				sparseSPrime.setOneHot(stateDim, index[t + 1]);
+				checksum += agent.getAction(sparseS, agentGenerator);
+				agent.train(agentGenerator, sparseS, action[t], reward, sparseSPrime, terminal);
+			}
+			if (terminal)
+				agent.newEpisode(agentGenerator);
+		}
+		seconds[run] = secondsSince(start);
+		benchmarkSink = (double)checksum;
+	}
+
+	FourierBasis fb;
+	fb.init(stateDim, iOrder, 0);
+	WeightMatrix w(numActions, fb.getNumOutputs());
+	ShiftedWeightMatrix sparseW;
+	sparseW.assign(w);
+	vector<double> phi;
+	SparseFeatures sparsePhi;
+	SparseState s;
+	uniform_real_distribution<double> step(-0.5, 0.5);
+	for (int t = 0; t < numSteps; t++) {
+		s.setOneHot(stateDim, index[t]);
+		fb.basify(s.toDense(), phi);
+		fb.basify(s, sparsePhi);
+		const double scale = step(generator);
+		w.addScaled(action[t], scale, phi);
+		sparseW.addScaled(action[t], scale, sparsePhi);
+	}
+	double maxDiff = 0;
+	for (int k = 0; k < stateDim; k++) {
+		s.setOneHot(stateDim, k);
+		fb.basify(s.toDense(), phi);
+		fb.basify(s, sparsePhi);
+		for (int a = 0; a < numActions; a++)
+			maxDiff = max(maxDiff, fabs(w.dot(a, phi) - sparseW.dot(a, sparsePhi)));
+	}
+	cout << name << "," << stateDim << "," << iOrder << "," << fb.getNumOutputs() << "," << 1e9 * seconds[0] / numSteps << ","
+		<< 1e9 * seconds[1] / numSteps << "," << seconds[0] / seconds[1] << "," << maxDiff << endl;
+}
+
+void benchmarkSparseState() {
+	cout << "agent,stateDim,iOrder,nTerms,dense ns/step,sparse ns/step,speedup,max q diff" << endl;
+	for (int stateDim : { 25, 100, 400, 1600, 6400 }) {
+		for (int iOrder : { 1, 2 }) {
+			benchmarkSparseStateOn<QLearning>("QLearning", stateDim, iOrder);
+			benchmarkSparseStateOn<Sarsa>("Sarsa", stateDim, iOrder);
+		}
+	}
+}
+
+void benchmarkTabular() {
+	const int numEpisodes = 2000, maxEpisodeLength = 1000;
+	Gridworld e;
+	cout << "agent,features,numFeatures,ns/step,last return" << endl;
+	benchmarkAgentSteps<QLearning, Gridworld>("QLearning", "Fourier 1/0", QLearning(e.getStateDim(), e.getNumActions(), 0.01, 1.0, 0.1, 1, 0), fourierNumTerms(e.getStateDim(), 1, 0), numEpisodes, maxEpisodeLength);
+	benchmarkAgentSteps<Sarsa, Gridworld>("Sarsa", "Fourier 1/0", Sarsa(e.getStateDim(), e.getNumActions(), 0.01, 1.0, 0.1, 1, 0), fourierNumTerms(e.getStateDim(), 1, 0), numEpisodes, maxEpisodeLength);
+	benchmarkAgentSteps<TabularQLearning, Gridworld>("TabularQLearning", "table", TabularQLearning(e.getNumStates(), e.getNumActions(), 0.1, 1.0, 0.1), e.getNumStates(), numEpisodes, maxEpisodeLength);
+	benchmarkAgentSteps<TabularSarsa, Gridworld>("TabularSarsa", "table", TabularSarsa(e.getNumStates(), e.getNumActions(), 0.1, 1.0, 0.1), e.getNumStates(), numEpisodes, maxEpisodeLength);
+}
+
+// Time per step of agent on the Gridworld e, over numEpisodes episodes of at most maxEpisodeLength steps, and its memory afterwards.
+template <typename Agent>
+static void benchmarkGridMapOn(const char * name, Gridworld e, Agent agent, const int & numEpisodes, const int & maxEpisodeLength) {
+	mt19937_64 generator(0);
+	int state, nextState;
+	long long numSteps = 0;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (int episode = 0; episode < numEpisodes; episode++) {
+		e.newEpisode(generator);
+		agent.newEpisode(generator);
+		e.getState(generator, state);
+		bool inTerminalState = false;
+		for (int t = 0; (t < maxEpisodeLength) && (!inTerminalState); t++) {
+			const int action = agent.getAction(state, generator);
+			double reward = e.update(action, generator);
+			e.getState(generator, nextState);
+			inTerminalState = e.inTerminalState();
+			agent.train(generator, state, action, reward, nextState, inTerminalState);
+			swap(state, nextState);
+			numSteps++;
+		}
+	}
+	const double seconds = secondsSince(start);
+	cout << e.getMap().getWidth() << "," << (long long)e.getMap().getNumCells() << "," << e.getMap().getMemory() << "," << name << ","
+		<< agent.getTrialMemory() << "," << numSteps << "," << 1e9 * seconds / numSteps << endl;
+}
+
+void benchmarkGridMap() {
+	const int numEpisodes = 10, maxEpisodeLength = 200000, maxDenseSize = 1000;
+	const string path = "benchmark_gridmap.bin";
+	cout << "size,cells,map bytes,agent,table bytes,steps,ns/step" << endl;
+	for (int size : { 100, 316, 1000, 3162, 10000 }) {
+		// Each map goes through a binary file, as a large map would be given
+		GridMap::random(size, size, 0.2, size).saveBinary(path);
+		Gridworld e(make_shared<GridMap>(GridMap::load(path)));
+		std::remove(path.c_str());
+		if (size <= maxDenseSize) {	// 4 doubles per cell: 32 MB at 1000 x 1000, 3.2 GB at 10000 x 10000
+			benchmarkGridMapOn("TabularQLearning", e, TabularQLearning(e.getNumStates(), e.getNumActions(), 0.1, 1.0, 0.1), numEpisodes, maxEpisodeLength);
+			benchmarkGridMapOn("TabularSarsa", e, TabularSarsa(e.getNumStates(), e.getNumActions(), 0.1, 1.0, 0.1), numEpisodes, maxEpisodeLength);
+		}
+		benchmarkGridMapOn("PagedTabularQLearning", e, PagedTabularQLearning(e.getNumStates(), e.getNumActions(), 0.1, 1.0, 0.1), numEpisodes, maxEpisodeLength);
+		benchmarkGridMapOn("PagedTabularSarsa", e, PagedTabularSarsa(e.getNumStates(), e.getNumActions(), 0.1, 1.0, 0.1), numEpisodes, maxEpisodeLength);
+	}
+}
+
+// Steps/sec of numLanes Environments stepped one at a time and of one Batched environment with numLanes lanes, on the same random
+// actions, with every lane that reaches a terminal state starting a new episode. Also checks that every lane of the batched
+// environment has the same states, rewards and terminal flags as its scalar environment, bit for bit.
+template <typename Environment, typename Batched>
+static void benchmarkBatchedEnvironmentOn(const char * name, const int & numLanes) {
+	const long long laneSteps = 1 << 20;
+	const int numSteps = (int)(laneSteps / numLanes);
+	mt19937_64 generator(0);
+	uniform_int_distribution<int> randomAction(0, Environment::numActions - 1);
+	vector<int> actions((size_t)numSteps * numLanes);
+	for (int & a : actions)
+		a = randomAction(generator);
+
+	vector<Environment> scalar(numLanes);
+	vector<double> rewards(numLanes);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (int t = 0; t < numSteps; t++) {
+		for (int k = 0; k < numLanes; k++) {
+			rewards[k] = scalar[k].update(actions[(size_t)t * numLanes + k], generator);
+			if (scalar[k].inTerminalState())
+				scalar[k].newEpisode(generator);
+		}
+	}
+	const double scalarSeconds = secondsSince(start);
+
+	Batched batched(numLanes);
+	vector<unsigned char> reset(numLanes);
+	start = chrono::steady_clock::now();
+	for (int t = 0; t < numSteps; t++) {
+		batched.update(&actions[(size_t)t * numLanes], rewards.data());
+		copy(batched.getTerminalMask(), batched.getTerminalMask() + numLanes, reset.begin());
+		batched.newEpisode(reset.data());
+	}
+	const double batchedSeconds = secondsSince(start);
+	benchmarkSink = rewards[0];
+
+	// The check, on fresh environments
+	bool identical = true;
+	vector<Environment> reference(numLanes);
+	Batched checked(numLanes);
+	vector<double> batchedRewards(numLanes), states((size_t)numLanes * Environment::stateDim);
+	typename Environment::State state;
+	for (int t = 0; (t < min(numSteps, 4096)) && identical; t++) {
+		checked.update(&actions[(size_t)t * numLanes], batchedRewards.data());
+		checked.getStates(states.data());
+		for (int k = 0; k < numLanes; k++) {
+			rewards[k] = reference[k].update(actions[(size_t)t * numLanes + k], generator);
+			reference[k].getState(generator, state);
+			identical = identical && (rewards[k] == batchedRewards[k]) && (reference[k].inTerminalState() == checked.inTerminalState(k))
+				&& equal(state.begin(), state.end(), states.begin() + (size_t)k * Environment::stateDim);
+			if (reference[k].inTerminalState())
+				reference[k].newEpisode(generator);
+		}
+		copy(checked.getTerminalMask(), checked.getTerminalMask() + numLanes, reset.begin());
+		checked.newEpisode(reset.data());
+	}
+	cout << name << "," << numLanes << "," << laneSteps / scalarSeconds << "," << laneSteps / batchedSeconds << "," << scalarSeconds / batchedSeconds << "," << (identical ? "yes" : "no") << endl;
+}
+
+void benchmarkBatchedEnvironments() {
+	cout << "environment,lanes,scalar steps/sec,batched steps/sec,speedup,identical" << endl;
+	for (int numLanes : { 1, 4, 16, 64, 256, 1024 }) {
+		benchmarkBatchedEnvironmentOn<MountainCar, BatchedMountainCar>("MountainCar", numLanes);
+		benchmarkBatchedEnvironmentOn<CartPole, BatchedCartPole>("CartPole", numLanes);
+		benchmarkBatchedEnvironmentOn<Acrobot, BatchedAcrobot>("Acrobot", numLanes);
+	}
+}
+
+// The returns of numTrials copies of agent on Environment, computed as runExperiment does (one trial per OpenMP iteration, trial t
+// with a generator seeded with t).
+template <typename Agent, typename Environment>
+static void runScalarTrials(const Agent & agent, const int & numTrials, const int & numEpisodes, const int & maxEpisodeLength, const double & gamma, vector<vector<double>> & returns) {
+	returns.assign(numTrials, vector<double>(numEpisodes, 0.0));
+	vector<Agent> agents(numTrials, agent);
+	#pragma omp parallel for
+	for (int trial = 0; trial < numTrials; trial++) {
+		Environment e;
+		mt19937_64 generator(trial);
+		typename ObservationType<Agent, Environment>::type state, nextState;
+		runTrialEpisodes(agents[trial], e, generator, state, nextState, 0, numEpisodes, maxEpisodeLength, gamma, returns[trial]);
+	}
+}
+
+// Time of numTrials trials of Agent on Environment run one at a time (as runExperiment does) and in lockstep with each number of
+// lanes (runLockstepTrials with LockstepAgent and Batched), and whether every return is bit-identical.
+template <typename Agent, typename LockstepAgent, typename Environment, typename Batched>
+static void benchmarkLockstepOn(const char * name, const double & alpha, const double & epsilon, const int & iOrder, const int & dOrder, const int & maxEpisodeLength) {
+	const int numTrials = 32, numEpisodes = 10;
+	const double gamma = 1.0;
+	vector<vector<double>> expected, returns;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	runScalarTrials<Agent, Environment>(Agent(Environment::stateDim, Environment::numActions, alpha, 1.0, epsilon, iOrder, dOrder), numTrials, numEpisodes, maxEpisodeLength, gamma, expected);
+	const double scalarSeconds = secondsSince(start);
+	for (int numLanes : { 1, 4, 8, 16, 32 }) {
+		start = chrono::steady_clock::now();
+		runLockstepTrials(LockstepAgent(numLanes, Environment::stateDim, Environment::numActions, alpha, 1.0, epsilon, iOrder, dOrder), Batched(numLanes), numTrials, numEpisodes, maxEpisodeLength, gamma, returns);
+		const double lockstepSeconds = secondsSince(start);
+		cout << name << "," << fourierNumTerms(Environment::stateDim, iOrder, dOrder) << "," << numLanes << "," << scalarSeconds << "," << lockstepSeconds << ","
+			<< scalarSeconds / lockstepSeconds << "," << ((returns == expected) ? "yes" : "no") << endl;
+	}
+}
+
+void benchmarkLockstep() {
+	cout << "agent,nTerms,lanes,runExperiment seconds,lockstep seconds,speedup,identical returns" << endl;
+	benchmarkLockstepOn<QLearning, LockstepQLearning, MountainCar, BatchedMountainCar>("QLearning MountainCar", 0.005, 0.0, 5, 0, 5000);
+	benchmarkLockstepOn<Sarsa, LockstepSarsa, MountainCar, BatchedMountainCar>("Sarsa MountainCar", 0.005, 0.0, 3, 3, 5000);
+	benchmarkLockstepOn<QLearning, LockstepQLearning, CartPole, BatchedCartPole>("QLearning CartPole", 0.001, 0.05, 4, 0, 2000);
+	benchmarkLockstepOn<Sarsa, LockstepSarsa, Acrobot, BatchedAcrobot>("Sarsa Acrobot", 0.001, 0.05, 2, 0, 2000);
+}
+
+// Time of a 5 alpha x 5 epsilon grid of Agent on Environment run as 25 runExperiment-style runs, and as one lockstep sweep
+// (runLockstepSweep with LockstepAgent and Batched), and whether every return is bit-identical.
+template <typename Agent, typename LockstepAgent, typename Environment, typename Batched>
+static void benchmarkSweepOn(const char * name, const int & iOrder, const int & dOrder, const int & maxEpisodeLength) {
+	const int numTrials = 8, numEpisodes = 5;
+	const double gamma = 1.0;
+	vector<double> alphas, epsilons;
+	for (double alpha : { 0.0005, 0.001, 0.002, 0.005, 0.01 }) {
+		for (double epsilon : { 0.0, 0.01, 0.05, 0.1, 0.2 }) {
+			alphas.push_back(alpha);
+			epsilons.push_back(epsilon);
+		}
+	}
+	const int numConfigs = (int)alphas.size();
+	vector<vector<vector<double>>> expected(numConfigs), returns;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (int c = 0; c < numConfigs; c++)
+		runScalarTrials<Agent, Environment>(Agent(Environment::stateDim, Environment::numActions, alphas[c], 1.0, epsilons[c], iOrder, dOrder), numTrials, numEpisodes, maxEpisodeLength, gamma, expected[c]);
+	const double scalarSeconds = secondsSince(start);
+	start = chrono::steady_clock::now();
+	runLockstepSweep(LockstepAgent(Environment::stateDim, Environment::numActions, alphas, 1.0, epsilons, iOrder, dOrder), Batched(numConfigs), numTrials, numEpisodes, maxEpisodeLength, gamma, returns);
+	const double sweepSeconds = secondsSince(start);
+	cout << name << "," << fourierNumTerms(Environment::stateDim, iOrder, dOrder) << "," << numConfigs << "," << scalarSeconds << "," << sweepSeconds << ","
+		<< scalarSeconds / sweepSeconds << "," << ((returns == expected) ? "yes" : "no") << endl;
+}
+
+void benchmarkSweep() {
+	cout << "agent,nTerms,configs,separate runs seconds,sweep seconds,speedup,identical returns" << endl;
+	benchmarkSweepOn<QLearning, LockstepQLearning, MountainCar, BatchedMountainCar>("QLearning MountainCar", 4, 0, 2000);
+	benchmarkSweepOn<Sarsa, LockstepSarsa, MountainCar, BatchedMountainCar>("Sarsa MountainCar", 3, 3, 2000);
+	benchmarkSweepOn<QLearning, LockstepQLearning, CartPole, BatchedCartPole>("QLearning CartPole", 4, 0, 2000);
+	benchmarkSweepOn<Sarsa, LockstepSarsa, Acrobot, BatchedAcrobot>("Sarsa Acrobot", 2, 0, 1000);
+}
+
+// runScalarTrials with the trials run by scheduler (in chunks of episodes, see TrialScheduler.hpp) instead of a static OpenMP loop.
+template <typename Agent, typename Environment>
+static void runScheduledTrials(TrialScheduler & scheduler, const int & numChunks, const Agent & agent, const int & numTrials, const int & numEpisodes, const int & maxEpisodeLength, const double & gamma, vector<vector<double>> & returns) {
+	returns.assign(numTrials, vector<double>(numEpisodes, 0.0));
+	vector<Agent> agents(numTrials, agent);
+	vector<Environment> environments(numTrials);
+	vector<mt19937_64> generators(numTrials);
+	for (int trial = 0; trial < numTrials; trial++)
+		generators[trial].seed(trial);
+	vector<typename ObservationType<Agent, Environment>::type> states(numTrials), nextStates(numTrials);
+	scheduler.run([&](int trial, int chunk) {
+		runTrialEpisodes(agents[trial], environments[trial], generators[trial], states[trial], nextStates[trial], chunk * numEpisodes / numChunks, (chunk + 1) * numEpisodes / numChunks, maxEpisodeLength, gamma, returns[trial]);
+	});
+}
+
+// Time of numTrials trials of Agent on Environment with the static OpenMP loop runExperiment used to have, and with the
+// work-stealing scheduler, first without and then with the run times of the first run as history, with the utilization of each
+// thread and whether the returns are bit-identical.
+template <typename Agent, typename Environment>
+static void benchmarkSchedulerOn(const char * name, const Agent & agent, const int & numTrials, const int & numEpisodes, const int & maxEpisodeLength) {
+	const double gamma = 1.0;
+	const int numChunks = min(numEpisodes, TrialScheduler::defaultChunksPerTrial);
+	vector<vector<double>> expected, returns;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	runScalarTrials<Agent, Environment>(agent, numTrials, numEpisodes, maxEpisodeLength, gamma, expected);
+	cout << name << ": static loop " << secondsSince(start) << " s" << endl;
+	vector<double> history;
+	for (const char * pass : { "without history", "with history" }) {
+		TrialScheduler scheduler(numTrials, numChunks, history);
+		start = chrono::steady_clock::now();
+		runScheduledTrials<Agent, Environment>(scheduler, numChunks, agent, numTrials, numEpisodes, maxEpisodeLength, gamma, returns);
+		cout << name << ": scheduler " << pass << " " << secondsSince(start) << " s, identical returns " << ((returns == expected) ? "yes" : "no") << endl;
+		scheduler.reportUtilization();
+		history = scheduler.getTrialSeconds();
+	}
+}
+
+void benchmarkScheduler() {
+	benchmarkSchedulerOn<QLearning, CartPole>("QLearning CartPole", QLearning(CartPole::stateDim, CartPole::numActions, 0.001, 1.0, 0.05, 4, 0), 64, 20, 5000);
+	benchmarkSchedulerOn<Sarsa, MountainCar>("Sarsa MountainCar", Sarsa(MountainCar::stateDim, MountainCar::numActions, 0.005, 1.0, 0.0, 3, 0), 32, 10, 5000);
+}
+
+// Time of a grid of Agent configurations on Environment run one configuration at a time, each with its own OpenMP loop over the
+// trials (as the loops in main do), and as one flattened SweepEngine sweep, and whether the means and variances are bit-identical.
+template <typename Agent, typename Environment>
+static void benchmarkSweepEngineOn(const char * name, const int & iOrder, const int & dOrder, const int & maxEpisodeLength) {
+	const int numTrials = 8, numEpisodes = 5;
+	const double gamma = 1.0;
+	vector<Agent> configs;
+	for (double alpha : { 0.001, 0.005, 0.01 })
+		for (double epsilon : { 0.0, 0.05 })
+			configs.push_back(Agent(Environment::stateDim, Environment::numActions, alpha, 1.0, epsilon, iOrder, dOrder));
+	const int numConfigs = (int)configs.size();
+	vector<vector<double>> expectedMeans(numConfigs), expectedVars(numConfigs), means(numConfigs), vars(numConfigs), returns;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (int c = 0; c < numConfigs; c++) {
+		runScalarTrials<Agent, Environment>(configs[c], numTrials, numEpisodes, maxEpisodeLength, gamma, returns);
+		vector<double> cur(numTrials);
+		for (int episode = 0; episode < numEpisodes; episode++) {
+			for (int trial = 0; trial < numTrials; trial++)
+				cur[trial] = returns[trial][episode];
+			expectedMeans[c].push_back(mean(cur));
+			expectedVars[c].push_back(var(cur));
+		}
+	}
+	const double loopSeconds = secondsSince(start);
+	start = chrono::steady_clock::now();
+	SweepEngine engine(ThreadPool::shared(), true);
+	for (int c = 0; c < numConfigs; c++) {
+		engine.add(configs[c], Environment(), numTrials, numEpisodes, maxEpisodeLength, gamma, [&, c](const vector<double> & m, const vector<double> & v) {
+			means[c] = m;
+			vars[c] = v;
+		});
+	}
+	engine.wait();
+	const double sweepSeconds = secondsSince(start);
+	cout << name << "," << numConfigs << "," << loopSeconds << "," << sweepSeconds << "," << loopSeconds / sweepSeconds << ","
+		<< (((means == expectedMeans) && (vars == expectedVars)) ? "yes" : "no") << endl;
+}
+
+void benchmarkSweepEngine() {
+	cout << "agent,configs,per-config loops seconds,flattened sweep seconds,speedup,identical results" << endl;
+	benchmarkSweepEngineOn<QLearning, MountainCar>("QLearning MountainCar", 3, 0, 2000);
+	benchmarkSweepEngineOn<Sarsa, CartPole>("Sarsa CartPole", 4, 0, 2000);
+	benchmarkSweepEngineOn<Sarsa, Acrobot>("Sarsa Acrobot", 2, 0, 1000);
+}
+
+// Episode 0 of one trial of agent on environment, then episodes 1..numEpisodes-1, counting the allocations of the latter.
+template <typename Agent, typename Environment>
+static bool checkAllocationsOn(const char * name, Agent agent, Environment environment, const int & numEpisodes, const int & maxEpisodeLength) {
+	mt19937_64 generator(0);
+	typename ObservationType<Agent, Environment>::type state, nextState;
+	vector<double> returns(numEpisodes, 0.0);
+	runTrialEpisodes(agent, environment, generator, state, nextState, 0, 1, maxEpisodeLength, 1.0, returns);
+	const long long start = getThreadAllocationCount();
+	runTrialEpisodes(agent, environment, generator, state, nextState, 1, numEpisodes, maxEpisodeLength, 1.0, returns);
+	const long long allocations = getThreadAllocationCount() - start;
+	cout << name << "," << allocations << "," << ((allocations == 0) ? "ok" : "FAIL") << endl;
+	return allocations == 0;
+}
+
+// FourierBasis::basify on one-hot sparse states with the given layout: the first call sizes the buffers, the rest are counted.
+static bool checkSparseBasifyAllocations(const CoefficientLayout & layout) {
+	const int stateDim = 8, numCalls = 1000;
+	FourierBasis fb;
+	fb.init(stateDim, 2, 1);
+	fb.setCoefficientLayout(layout);
+	SparseState s;
+	SparseFeatures phi;
+	s.setOneHot(stateDim, 0);
+	fb.basify(s, phi);
+	const long long start = getThreadAllocationCount();
+	for (int n = 0; n < numCalls; n++) {
+		s.setOneHot(stateDim, n % stateDim);
+		fb.basify(s, phi);
+	}
+	const long long allocations = getThreadAllocationCount() - start;
+	cout << "basify(SparseState) " << layoutName(layout) << "," << allocations << "," << ((allocations == 0) ? "ok" : "FAIL") << endl;
+	return allocations == 0;
+}
+
+bool checkAllocations() {
+#ifndef COUNT_ALLOCATIONS
+	cout << "FAIL: allocations are not counted in this build (NO_COUNT_ALLOCATIONS is defined)" << endl;
+	return false;
+#else
+	const int numEpisodes = 5;
+	bool ok = true;
+	cout << "pair,allocations after episode 0,result" << endl;
+	ok = checkAllocationsOn("QLearning MountainCar", QLearning(2, 3, 0.005, 1.0, 0.0, 3, 0), MountainCar(), numEpisodes, 2000) && ok;
+	ok = checkAllocationsOn("Sarsa MountainCar", Sarsa(2, 3, 0.005, 1.0, 0.0, 3, 3), MountainCar(), numEpisodes, 2000) && ok;
+	ok = checkAllocationsOn("QLearning CartPole", QLearning(4, 2, 0.001, 1.0, 0.1, 4, 0), CartPole(), numEpisodes, 2000) && ok;
+	ok = checkAllocationsOn("Sarsa Acrobot", Sarsa(4, 3, 0.001, 1.0, 0.3, 2, 0), Acrobot(), numEpisodes, 1000) && ok;
+	ok = checkAllocationsOn("QLearning Gridworld", QLearning(Gridworld().getStateDim(), 4, 0.01, 1.0, 0.1, 2, 0), Gridworld(), numEpisodes, 1000) && ok;
+	ok = checkAllocationsOn("Sarsa Gridworld", Sarsa(Gridworld().getStateDim(), 4, 0.01, 1.0, 0.1, 1, 0), Gridworld(), numEpisodes, 1000) && ok;
+	ok = checkAllocationsOn("TabularQLearning Gridworld", TabularQLearning(Gridworld().getNumStates(), 4, 0.01, 1.0, 0.1), Gridworld(), numEpisodes, 1000) && ok;
+	ok = checkAllocationsOn("TabularSarsa Gridworld", TabularSarsa(Gridworld().getNumStates(), 4, 0.01, 1.0, 0.1), Gridworld(), numEpisodes, 1000) && ok;
+	ok = checkAllocationsOn("TileCodingQLearning MountainCar", TileCodingQLearning(2, 3, 0.5 / 8, 1.0, 0.0, 8, 8), MountainCar(), numEpisodes, 2000) && ok;
+	ok = checkAllocationsOn("TileCodingSarsa MountainCar", TileCodingSarsa(2, 3, 0.5 / 8, 1.0, 0.0, 8, 8), MountainCar(), numEpisodes, 2000) && ok;
+	withQLearningAgent(2, 3, 0.005, 1.0, 0.0, 5, 0, [&](auto & a) { ok = checkAllocationsOn("Prebuilt QLearning MountainCar", a, MountainCar(), numEpisodes, 2000) && ok; });
+	withSarsaAgent(4, 2, 0.001, 1.0, 0.1, 4, 0, [&](auto & a) { ok = checkAllocationsOn("Prebuilt Sarsa CartPole", a, CartPole(), numEpisodes, 2000) && ok; });
+	for (CoefficientLayout layout : { CoefficientLayout::Dense, CoefficientLayout::Sparse, CoefficientLayout::Implicit })
+		ok = checkSparseBasifyAllocations(layout) && ok;
+	cout << (ok ? "No allocations after the first episode" : "FAIL: steady-state steps allocated") << endl;
+	return ok;
+#endif
+}
@@ -2,17 +2,20 @@
 
 using namespace std;
 
+constexpr int CartPole::stateDim;
+constexpr int CartPole::numActions;
+
 CartPole::CartPole() {
 	mt19937_64 generator(0);
 	newEpisode(generator);
 }
 
 int CartPole::getStateDim() const {
-	return 4;
+	return stateDim;
 }
 
 int CartPole::getNumActions() const {
-	return 2;
+	return numActions;
 }
 
 double CartPole::update(const int & action, mt19937_64 & generator) {
@@ -35,12 +38,25 @@ double CartPole::update(const int & action, mt19937_64 & generator) {
 }
 
 vector<double> CartPole::getState(mt19937_64 & generator) {
-	vector<double> result(4);
+	vector<double> result;
+	getState(generator, result);
+	return result;
+}
+
+void CartPole::getState(mt19937_64 & generator, vector<double> & result) {
+	result.resize(stateDim);
+	writeState(result.data());
+}
+
+void CartPole::getState(mt19937_64 & generator, State & result) {
+	writeState(result.data());
+}
+
+void CartPole::writeState(double * result) const {
 	result[0] = normalize(x, xMin, xMax);
 	result[1] = normalize(v, vMin, vMax);
 	result[2] = normalize(theta, thetaMin, thetaMax);
 	result[3] = normalize(omega, omegaMin, omegaMax);
-	return result;
 }
 
 bool CartPole::inTerminalState() const {
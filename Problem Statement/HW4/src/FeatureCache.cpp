@@ -0,0 +1,119 @@
+#include "stdafx.h"
+
+using namespace std;
+
+FeatureCache::FeatureCache() {
+}
+
+FeatureCache::FeatureCache(const shared_ptr<const FourierBasis> & basis, const int & capacity, const vector<double> & cellSize) {
+	reset(basis, capacity, cellSize);
+}
+
+void FeatureCache::reset(const shared_ptr<const FourierBasis> & basis, const int & capacity, const vector<double> & cellSize) {
+	this->basis = basis;
+	this->capacity = capacity;
+	this->cellSize = cellSize;
+	inputDimension = basis->getInputDimension();
+	nTerms = basis->getNumOutputs();
+	if (!cellSize.empty() && ((int)cellSize.size() != inputDimension))
+		throw invalid_argument("FeatureCache: cellSize must be empty or have one entry per input");
+	int numBuckets = 1;
+	while (numBuckets < 2 * capacity)	// At most one entry per two buckets, so the chains stay short
+		numBuckets *= 2;
+	keys.assign((size_t)capacity * inputDimension, 0);
+	features.assign((size_t)capacity * nTerms, 0.0);
+	bucketHead.assign(numBuckets, -1);
+	nextInBucket.assign(capacity, -1);
+	entryBucket.assign(capacity, 0);
+	referenced.assign(capacity, 0);
+	key.assign(inputDimension, 0);
+	center.assign(cellSize.empty() ? 0 : inputDimension, 0.0);
+	numEntries = clockHand = 0;
+	numHits = numMisses = numEvictions = 0;
+}
+
+bool FeatureCache::isEnabled() const {
+	return capacity > 0;
+}
+
+void FeatureCache::makeKey(const double * x) {
+	if (cellSize.empty()) {
+		memcpy(key.data(), x, inputDimension * sizeof(double));	// The bits of the observation
+		return;
+	}
+	for (int k = 0; k < inputDimension; k++) {
+		const double cell = floor(x[k] / cellSize[k]);
+		key[k] = (unsigned long long)(long long)cell;
+		center[k] = (cell + 0.5) * cellSize[k];
+	}
+}
+
+int FeatureCache::bucketOf(const unsigned long long * key) const {
+	unsigned long long h = 0;
+	for (int k = 0; k < inputDimension; k++) {	// splitmix64 finalizer over each word, chained
+		unsigned long long z = h + key[k] + 0x9e3779b97f4a7c15ULL;
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		h = z ^ (z >> 31);
+	}
+	return (int)(h & (unsigned long long)(bucketHead.size() - 1));
+}
+
+const double * FeatureCache::lookup(const double * x) {
+	makeKey(x);
+	const int bucket = bucketOf(key.data());
+	for (int e = bucketHead[bucket]; e != -1; e = nextInBucket[e]) {
+		if (equal(key.begin(), key.end(), keys.begin() + (size_t)e * inputDimension)) {
+			numHits++;
+			referenced[e] = 1;
+			return &features[(size_t)e * nTerms];
+		}
+	}
+	numMisses++;
+	const int e = (numEntries < capacity) ? numEntries++ : evict();
+	copy(key.begin(), key.end(), keys.begin() + (size_t)e * inputDimension);
+	entryBucket[e] = bucket;
+	nextInBucket[e] = bucketHead[bucket];
+	bucketHead[bucket] = e;
+	referenced[e] = 1;
+	double * result = &features[(size_t)e * nTerms];
+	basis->basifyBatch(cellSize.empty() ? x : center.data(), 1, result);	// A batch of one state: the same values as basify
+	return result;
+}
+
+int FeatureCache::evict() {
+	while (referenced[clockHand]) {
+		referenced[clockHand] = 0;
+		clockHand = (clockHand + 1) % capacity;
+	}
+	const int victim = clockHand;
+	clockHand = (clockHand + 1) % capacity;
+	int * link = &bucketHead[entryBucket[victim]];	// Unlink the victim from its chain
+	while (*link != victim)
+		link = &nextInBucket[*link];
+	*link = nextInBucket[victim];
+	numEvictions++;
+	return victim;
+}
+
+void FeatureCache::basify(const vector<double> & x, vector<double> & result) {
+	const double * phi = lookup(x.data());
+	result.assign(phi, phi + nTerms);
+}
+
+long long FeatureCache::getNumHits() const {
+	return numHits;
+}
+
+long long FeatureCache::getNumMisses() const {
+	return numMisses;
+}
+
+long long FeatureCache::getNumEvictions() const {
+	return numEvictions;
+}
+
+size_t FeatureCache::getMemory() const {
+	return keys.capacity() * sizeof(unsigned long long) + features.capacity() * sizeof(double)
+		+ (bucketHead.capacity() + nextInBucket.capacity() + entryBucket.capacity()) * sizeof(int) + referenced.capacity();
+}
@@ -2,37 +2,429 @@
 
 using namespace std;
 
+// Definitions of the static constants, which std::min takes by reference
+const int FourierBasis::maxRecurrenceSteps;
+const int FourierBasis::defaultCoupledTermBudget;
+const unsigned long long FourierBasis::coupledSampleSeed;
+const int FourierBasis::batchTermBlock;
+const int FourierBasis::batchGroupSize;
+const int FourierBasis::batchChunkSize;
+const int FourierBasis::minParallelBatch;
+const int FourierBasis::maxImplicitInputs;
+
 void FourierBasis::init(const int & inputDimension, int iOrder, int dOrder) {
+	init(inputDimension, iOrder, dOrder, defaultCoupledTermBudget);
+}
+
+void FourierBasis::init(const int & inputDimension, int iOrder, int dOrder, const int & coupledTermBudget) {
 	this->inputDimension = inputDimension;					// Copy over the provided arguments
-	// Compute the total number of terms
-	int iTerms = iOrder*inputDimension;						// Number of independent terms
-	int dTerms = ipow(dOrder + 1, inputDimension);			// Number of dependent terms
-	int oTerms = min(iOrder, dOrder)*inputDimension;		// Overlap of iTerms and dTerms
-	nTerms = iTerms + dTerms - oTerms;
-	// Initialize c
-	c.resize(nTerms);
+	// Compute the total number of terms, in 64 bits, so that an oversized coupled block is detected rather than overflowing
+	const long long fullDTerms = countCoupledTerms(inputDimension, dOrder);
+	coupledSubsampled = (fullDTerms < 0) || (fullDTerms > coupledTermBudget);
+	vector<vector<int>> sampled;
+	if (coupledSubsampled)
+		sampled = sampleCoupledTerms(inputDimension, dOrder, coupledTermBudget);
+	const long long dTerms = coupledSubsampled ? (long long)sampled.size() : fullDTerms;	// Number of dependent terms
+	numHarmonics = max(0, iOrder - dOrder);
+	const long long totalTerms = dTerms + (long long)inputDimension * numHarmonics;		// Independent terms of order <= dOrder are in the dependent block
+	if (totalTerms > INT_MAX)
+		throw overflow_error("FourierBasis: too many terms (use a smaller iOrder)");
+	nTerms = (int)totalTerms;
+	firstIndependent = (int)dTerms;
+	firstHarmonic = dOrder + 1;
+	buildRows(sampled);
+	layout = CoefficientLayout::Sparse;	// The rows are all there is so far
+	setCoefficientLayout((getNumNonzeros() * sparseDensity <= (long long)nTerms * inputDimension) ? CoefficientLayout::Sparse : CoefficientLayout::Dense);
+}
+
+void FourierBasis::buildRows(const vector<vector<int>> & sampled) {
+	rowStart.assign(1, 0);
+	termIndex.clear();
+	termCoefficient.clear();
+	const int dOrder = firstHarmonic - 1;
 	vector<double> counter(inputDimension, 0.0);
-	int termCount = 0;
-	for (; termCount < dTerms; termCount++) {				// First add the dependent terms
-		c[termCount] = counter;
-		incrementCounter(counter, dOrder);
+	for (int termCount = 0; termCount < firstIndependent; termCount++) {	// First add the dependent terms
+		if (coupledSubsampled)
+			copy(sampled[termCount].begin(), sampled[termCount].end(), counter.begin());
+		for (int k = 0; k < inputDimension; k++) {
+			if (counter[k] != 0) {
+				termIndex.push_back(k);
+				termCoefficient.push_back((int)counter[k]);
+			}
+		}
+		rowStart.push_back((int)termIndex.size());
+		if (!coupledSubsampled)
+			incrementCounter(counter, dOrder);
 	}
 	for (int i = 0; i < inputDimension; i++) {				// Add the independent terms
-		for (int j = dOrder + 1; j <= iOrder; j++) {
-			c[termCount] = vector<double>(inputDimension, 0.0);
-			c[termCount][i] = (double)j;
-			termCount++;
+		for (int j = firstHarmonic; j < firstHarmonic + numHarmonics; j++) {
+			termIndex.push_back(i);
+			termCoefficient.push_back(j);
+			rowStart.push_back((int)termIndex.size());
+		}
+	}
+}
+
+long long FourierBasis::countCoupledTerms(const int & inputDimension, const int & dOrder) {
+	long long result = 1;
+	for (int k = 0; k < inputDimension; k++) {
+		if (result > LLONG_MAX / (dOrder + 1))
+			return -1;
+		result *= dOrder + 1;
+	}
+	return result;
+}
+
+bool FourierBasis::isCoupledBlockSubsampled() const {
+	return coupledSubsampled;
+}
+
+vector<vector<int>> FourierBasis::sampleCoupledTerms(const int & inputDimension, const int & dOrder, const int & budget) {
+	// Ordered like incrementCounter enumerates the full block: input 0 is the fastest-changing digit
+	auto counterOrder = [](const vector<int> & a, const vector<int> & b) {
+		return lexicographical_compare(a.rbegin(), a.rend(), b.rbegin(), b.rend());
+	};
+	set<vector<int>, decltype(counterOrder)> chosen(counterOrder);
+	vector<int> counter(inputDimension, 0);
+	chosen.insert(counter);								// The constant term
+	for (int k = 0; k < inputDimension; k++) {			// The single-input terms
+		for (int m = 1; m <= dOrder; m++) {
+			counter[k] = m;
+			chosen.insert(counter);
 		}
+		counter[k] = 0;
+	}
+	mt19937_64 generator(coupledSampleSeed);
+	uniform_int_distribution<int> digit(0, dOrder);
+	while ((int)chosen.size() < budget) {				// The block has more than budget terms, so this terminates
+		for (int k = 0; k < inputDimension; k++)
+			counter[k] = digit(generator);
+		chosen.insert(counter);
+	}
+	return vector<vector<int>>(chosen.begin(), chosen.end());
+}
+
+void FourierBasis::setCoefficientLayout(const CoefficientLayout & layout) {
+	if ((layout == CoefficientLayout::Implicit) && !supportsImplicitLayout())
+		throw invalid_argument("FourierBasis: the implicit layout needs the whole coupled block and at most maxImplicitInputs inputs");
+	if ((layout != CoefficientLayout::Implicit) && (this->layout == CoefficientLayout::Implicit))
+		buildRows(vector<vector<int>>());	// Only a complete coupled block can be implicit, so there are no sampled terms to pass
+	this->layout = layout;
+	if (layout != CoefficientLayout::Dense)
+		AlignedVector().swap(c);	// Release the dense copy
+	if (layout == CoefficientLayout::Implicit) {
+		vector<int>().swap(rowStart);	// and the rows
+		vector<int>().swap(termIndex);
+		vector<int>().swap(termCoefficient);
+		vector<int>().swap(columnStart);	// and the columns
+		vector<int>().swap(columnTerm);
+		vector<int>().swap(columnCoefficient);
 	}
+	else
+		getCoefficientColumns(columnStart, columnTerm, columnCoefficient);	// For sparse states
+	if (layout != CoefficientLayout::Dense)
+		return;
+	// Pad each column to a whole number of cache lines (the padding stays zero).
+	const int lineDoubles = (int)(simdAlignment / sizeof(double));
+	stride = ((nTerms + lineDoubles - 1) / lineDoubles) * lineDoubles;
+	c.assign((size_t)stride * inputDimension, 0.0);
+	for (int i = 0; i < nTerms; i++)
+		for (int e = rowStart[i]; e < rowStart[i + 1]; e++)
+			c[(size_t)termIndex[e] * stride + i] = (double)termCoefficient[e];
+}
+
+CoefficientLayout FourierBasis::getCoefficientLayout() const {
+	return layout;
+}
+
+bool FourierBasis::supportsImplicitLayout() const {
+	return !coupledSubsampled && ((inputDimension <= maxImplicitInputs) || (firstHarmonic == 1));
+}
+
+long long FourierBasis::getNumNonzeros() const {
+	if (layout != CoefficientLayout::Implicit)
+		return (long long)termIndex.size();
+	// Each input has a nonzero digit in dOrder of every dOrder+1 counters of the full block, and one nonzero per independent term
+	const long long dOrder = firstHarmonic - 1;
+	return (long long)inputDimension * (firstIndependent / (dOrder + 1)) * dOrder + (long long)inputDimension * numHarmonics;
+}
+
+size_t FourierBasis::getCoefficientMemory() const {
+	return c.capacity() * sizeof(double) + (rowStart.capacity() + termIndex.capacity() + termCoefficient.capacity()
+		+ columnStart.capacity() + columnTerm.capacity() + columnCoefficient.capacity()) * sizeof(int);
+}
+
+size_t FourierBasis::getMemory() const {
+	return sizeof(FourierBasis) + getCoefficientMemory();
 }
 
 int FourierBasis::getNumOutputs() const {
 	return nTerms;
 }
 
+int FourierBasis::getInputDimension() const {
+	return inputDimension;
+}
+
+void FourierBasis::getArguments(const double * x, double * out) const {
+	computeArguments(x, 0, nTerms, out);
+}
+
+void FourierBasis::getCoefficientColumns(vector<int> & columnStart, vector<int> & columnTerm, vector<int> & columnCoefficient) const {
+	columnStart.assign(inputDimension + 1, 0);
+	forEachNonzero([&](const int &, const int & k, const int &) { columnStart[k + 1]++; });
+	for (int k = 0; k < inputDimension; k++)
+		columnStart[k + 1] += columnStart[k];
+	columnTerm.resize(columnStart[inputDimension]);
+	columnCoefficient.resize(columnStart[inputDimension]);
+	vector<int> next(columnStart.begin(), columnStart.end() - 1);
+	forEachNonzero([&](const int & i, const int & k, const int & coefficient) {
+		const int e = next[k]++;
+		columnTerm[e] = i;
+		columnCoefficient[e] = coefficient;
+	});
+}
+
 vector<double> FourierBasis::basify(const vector<double> & x) const {
-	vector<double> result(nTerms);
-	for (int i = 0; i < nTerms; i++)
-		result[i] = cos(M_PI*dot(c[i], x));
+	vector<double> result;
+	basify(x, result);
+	return result;
+}
+
+void FourierBasis::basify(const vector<double> & x, vector<double> & result) const {
+	result.resize(nTerms);
+	double * out = result.data();
+	// Terms before numDirect get their cosine evaluated directly; the rest (if any) come from the harmonic recurrence.
+	const int numDirect = harmonicRecurrence ? firstIndependent : nTerms;
+	computeArguments(x.data(), 0, numDirect, out);
+	cosPi(out, out, numDirect, cosineMode);	// Cosine pass over the arguments, in place.
+	if (numDirect < nTerms)
+		evaluateHarmonics(x.data(), out);
+}
+
+void FourierBasis::basify(const SparseState & x, SparseFeatures & result) const {
+	assert(x.getDimension() == inputDimension);
+	const int * index = x.getIndices();
+	const double * value = x.getValues();
+	if (layout == CoefficientLayout::Implicit) {
+		// No columns to walk: take every argument from the dense state. Terms that x does not touch get a deviation of zero.
+		const double * dense = result.denseInput(x);
+		computeArguments(dense, 0, nTerms, result.beginAllArguments(nTerms));
+	}
+	else {
+		result.beginArguments(nTerms);
+		// The nonzeros are visited in increasing order of input, so each argument adds the same products in the same order as
+		// computeArguments, without the products with zero inputs. The arguments are then bit-identical.
+		for (int e = 0; e < x.getNumNonzeros(); e++) {
+			const int k = index[e];
+			for (int j = columnStart[k]; j < columnStart[k + 1]; j++)
+				result.addArgument(columnTerm[j], (double)columnCoefficient[j] * value[e]);
+		}
+	}
+	result.endArguments(cosineMode);
+}
+
+void FourierBasis::computeArguments(const double * x, const int & begin, const int & end, double * out) const {
+	if (layout == CoefficientLayout::Implicit) {
+		computeImplicitArguments(x, begin, end, out);
+		return;
+	}
+	if (layout == CoefficientLayout::Sparse) {
+		// Sparse rows. Skipping the zero coefficients only skips additions of +-0, so this is bit-identical to the dense product.
+		for (int i = begin; i < end; i++) {
+			double result = 0;
+			for (int e = rowStart[i]; e < rowStart[i + 1]; e++)
+				result += (double)termCoefficient[e] * x[termIndex[e]];
+			out[i - begin] = result;
+		}
+		return;
+	}
+	// Dense matrix-vector product C*x, one column at a time. Each term accumulates its inputs in the order 0..inputDimension-1,
+	// which is the same order dot(c[i], x) used, so the arguments (and features) are bit-identical to a row-by-row dot product.
+	const int n = end - begin;
+	for (int i = 0; i < n; i++)
+		out[i] = 0;
+	for (int k = 0; k < inputDimension; k++) {
+		const double * col = &c[(size_t)k*stride + begin];
+		const double xk = x[k];
+		for (int i = 0; i < n; i++)
+			out[i] += col[i] * xk;
+	}
+}
+
+void FourierBasis::computeImplicitArguments(const double * x, const int & begin, const int & end, double * out) const {
+	const int radix = firstHarmonic;		// dOrder+1
+	const int coupledEnd = min(end, firstIndependent);
+	int i = begin;
+	if ((i < coupledEnd) && (radix == 1)) {	// dOrder 0: the block is the constant term
+		out[0] = 0;
+		i++;
+	}
+	if (i < coupledEnd) {
+		// digit[k] is the coefficient of input k in term i, and suffix[k] = sum over k' >= k of digit[k']*x[k'], added from the last
+		// input down and skipping the zero digits. Moving to the next term increments digit 0, carrying into higher digits; when
+		// digit k changes, suffix[k] is recomputed from suffix[k+1], and the lower digits are all zero, so their sums equal suffix[k].
+		int digit[maxImplicitInputs];
+		double suffix[maxImplicitInputs + 1];
+		int t = i;
+		for (int k = 0; k < inputDimension; k++) {
+			digit[k] = t % radix;
+			t /= radix;
+		}
+		suffix[inputDimension] = 0;
+		for (int k = inputDimension - 1; k >= 0; k--)
+			suffix[k] = (digit[k] != 0) ? (double)digit[k] * x[k] + suffix[k + 1] : suffix[k + 1];
+		for (;;) {
+			out[i - begin] = suffix[0];
+			if (++i == coupledEnd)
+				break;
+			int k = 0;
+			while (digit[k] == radix - 1)	// Terminates: term i exists, so the counter has not wrapped around
+				digit[k++] = 0;
+			digit[k]++;
+			suffix[k] = (double)digit[k] * x[k] + suffix[k + 1];
+			for (int j = 0; j < k; j++)
+				suffix[j] = suffix[k];
+		}
+	}
+	for (; i < end; i++) {					// Independent terms: one nonzero, j*x[k]
+		const int t = i - firstIndependent;
+		double result = 0;
+		result += (double)(firstHarmonic + t % numHarmonics) * x[t / numHarmonics];
+		out[i - begin] = result;
+	}
+}
+
+void FourierBasis::basifyBatch(const double * states, const int & numStates, double * features) const {
+	const int numChunks = (numStates + batchChunkSize - 1) / batchChunkSize;
+	if (numStates < minParallelBatch) {
+		// Small batches (the lanes of a lockstep step) stay out of OpenMP: opening even a one-thread region inside the parallel
+		// loop over trials costs more than basifying a few states.
+		for (int chunk = 0; chunk < numChunks; chunk++)
+			basifyChunk(states, chunk * batchChunkSize, min(numStates, (chunk + 1) * batchChunkSize), features);
+		return;
+	}
+	#pragma omp parallel for schedule(dynamic)
+	for (int chunk = 0; chunk < numChunks; chunk++)
+		basifyChunk(states, chunk * batchChunkSize, min(numStates, (chunk + 1) * batchChunkSize), features);
+}
+
+void FourierBasis::basifyChunk(const double * states, const int & first, const int & last, double * features) const {
+	const int numDirect = harmonicRecurrence ? firstIndependent : nTerms;
+	for (int begin = 0; begin < numDirect; begin += batchTermBlock) {
+		const int end = min(numDirect, begin + batchTermBlock);
+		for (int n = first; n < last; n += batchGroupSize) {
+			const int count = min(batchGroupSize, last - n);
+			double * out = features + (size_t)n * nTerms + begin;
+			computeArgumentsGroup(states + (size_t)n * inputDimension, count, begin, end, out, nTerms);
+			for (int m = 0; m < count; m++)
+				cosPi(out + (size_t)m * nTerms, out + (size_t)m * nTerms, end - begin, cosineMode);
+		}
+	}
+	if (numDirect < nTerms) {
+		for (int n = first; n < last; n++)
+			evaluateHarmonics(states + (size_t)n * inputDimension, features + (size_t)n * nTerms);
+	}
+}
+
+void FourierBasis::basifyBatch(const vector<double> & states, vector<double> & features) const {
+	const int numStates = (int)(states.size() / inputDimension);
+	features.resize((size_t)numStates * nTerms);
+	basifyBatch(states.data(), numStates, features.data());
+}
+
+void FourierBasis::computeArgumentsGroup(const double * x, const int & count, const int & begin, const int & end, double * out, const int & outStride) const {
+	if ((layout != CoefficientLayout::Dense) || (count != batchGroupSize)) {
+		for (int m = 0; m < count; m++)
+			computeArguments(x + (size_t)m * inputDimension, begin, end, out + (size_t)m * outStride);
+		return;
+	}
+	// The dense product for four states at once: each coefficient is loaded once and used for all four. Every output gets exactly
+	// the operations it gets in computeArguments, in the same order.
+	const int n = end - begin;
+	double * out0 = out, * out1 = out + outStride, * out2 = out + 2 * (size_t)outStride, * out3 = out + 3 * (size_t)outStride;
+	for (int i = 0; i < n; i++)
+		out0[i] = out1[i] = out2[i] = out3[i] = 0;
+	for (int k = 0; k < inputDimension; k++) {
+		const double * col = &c[(size_t)k*stride + begin];
+		const double x0 = x[k], x1 = x[inputDimension + k], x2 = x[2 * inputDimension + k], x3 = x[3 * inputDimension + k];
+		for (int i = 0; i < n; i++) {
+			out0[i] += col[i] * x0;
+			out1[i] += col[i] * x1;
+			out2[i] += col[i] * x2;
+			out3[i] += col[i] * x3;
+		}
+	}
+}
+
+void FourierBasis::evaluateHarmonics(const double * x, double * out) const {
+	for (int k = 0; k < inputDimension; k++) {
+		const double * dependent = coupledSubsampled ? nullptr : out;	// Seeds are only read from a complete dependent block
+		const double cosA = harmonicBase(x, k, dependent);
+		for (int n = 0; n < numHarmonics; n += maxRecurrenceSteps)
+			evaluateHarmonicRun(x, k, n, min(maxRecurrenceSteps, numHarmonics - n), cosA, dependent, out + firstIndependent + k*numHarmonics + n);
+	}
+}
+
+double FourierBasis::harmonicBase(const double * x, const int & k, const double * dependent) const {
+	// cos(pi*x[k]). When dOrder >= 1 it is already in the dependent block, as the term with counter e_k.
+	if ((firstHarmonic > 1) && (dependent != nullptr))
+		return dependent[ipow(firstHarmonic, k)];
+	return cosPiOne(x[k]);
+}
+
+void FourierBasis::evaluateHarmonicRun(const double * x, const int & k, const int & n0, const int & count, const double & cosA, const double * dependent, double * h) const {
+	const int unit = (dependent != nullptr) ? ipow(firstHarmonic, k) : 0;	// The dependent term with counter m*e_k (m <= dOrder) is at index m*unit
+	const int j0 = firstHarmonic + n0;
+	// Start from directly evaluated cosines of (j0-2)a and (j0-1)a, so the error cannot build up over more than one run
+	double prev = harmonic(x[k], j0 - 2, cosA, unit, dependent), cur = harmonic(x[k], j0 - 1, cosA, unit, dependent);
+	for (int n = 0; n < count; n++) {
+		const double next = 2.0 * cosA * cur - prev;
+		prev = cur;
+		cur = next;
+		h[n] = cur;
+	}
+}
+
+double FourierBasis::harmonic(const double & a, int m, const double & cosA, const int & unit, const double * dependent) const {
+	m = abs(m);
+	if (m == 0)
+		return 1.0;
+	if (m == 1)
+		return cosA;
+	if ((m < firstHarmonic) && (dependent != nullptr))	// m <= dOrder: already computed as a dependent term
+		return dependent[m*unit];
+	return cosPiOne((double)m * a);	// Same argument (and so the same bits) as the dependent term c.x = m*a
+}
+
+double FourierBasis::cosPiOne(const double & t) const {
+	double result;
+	cosPi(&t, &result, 1, cosineMode);
 	return result;
-}
\ No newline at end of file
+}
+
+void FourierBasis::setCosineMode(const CosineMode & mode) {
+	cosineMode = mode;
+}
+
+CosineMode FourierBasis::getCosineMode() const {
+	return cosineMode;
+}
+
+void FourierBasis::setHarmonicRecurrence(const bool & enabled) {
+	harmonicRecurrence = enabled;
+}
+
+int FourierBasis::getNumCosineEvaluations() const {
+	if (!harmonicRecurrence)
+		return nTerms;
+	if (numHarmonics == 0)
+		return firstIndependent;
+	const int firstEvaluated = coupledSubsampled ? 2 : max(2, firstHarmonic);	// Lowest multiple m whose seed cos(pi*m*a) is evaluated
+	int perInput = ((firstHarmonic > 1) && !coupledSubsampled) ? 0 : 1;	// cos(pi*a), unless it is in the dependent block. Then one per restart seed that is not free:
+	for (int n = 0; n < numHarmonics; n += maxRecurrenceSteps) {
+		const int j = firstHarmonic + n;
+		perInput += ((abs(j - 2) >= firstEvaluated) ? 1 : 0) + ((abs(j - 1) >= firstEvaluated) ? 1 : 0);
+	}
+	return firstIndependent + inputDimension * perInput;
+}
@@ -0,0 +1,204 @@
+#include "stdafx.h"
+
+using namespace std;
+
+static const char gridMapMagic[8] = { 'G', 'R', 'I', 'D', 'M', 'A', 'P', '1' };
+
+GridMap::GridMap(const int & width, const int & height) : width(width), height(height) {
+	if ((width < 1) || (height < 1) || ((long long)width * height > INT_MAX))
+		throw invalid_argument("GridMap: the grid must have between 1 and INT_MAX cells");
+	start = 0;
+	goal = getNumCells() - 1;
+	offset[0] = width;
+	offset[1] = -width;
+	offset[2] = -1;
+	offset[3] = 1;
+	walls.assign(((size_t)getNumCells() + 63) / 64, 0);
+	moves.assign(((size_t)getNumCells() + 1) / 2, 0);
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			updateMoves(x, y);
+}
+
+GridMap GridMap::load(const string & path) {
+	ifstream in(path, ios::binary);
+	if (!in)
+		throw runtime_error("GridMap: cannot open " + path);
+	char magic[sizeof(gridMapMagic)] = { 0 };
+	in.read(magic, sizeof(magic));
+	const bool binary = (in.gcount() == sizeof(magic)) && equal(magic, magic + sizeof(magic), gridMapMagic);
+	if (!binary) {
+		in.clear();
+		in.seekg(0);
+	}
+	return binary ? loadBinary(in) : loadText(in);
+}
+
+GridMap GridMap::loadText(istream & in) {
+	vector<string> rows;
+	string line;
+	while (getline(in, line)) {
+		if (!line.empty() && (line.back() == '\r'))
+			line.pop_back();
+		if (!line.empty())
+			rows.push_back(line);
+	}
+	if (rows.empty())
+		throw invalid_argument("GridMap: the map file has no rows");
+	GridMap result((int)rows[0].size(), (int)rows.size());
+	int startX = 0, startY = 0, goalX = result.width - 1, goalY = result.height - 1;
+	for (int r = 0; r < result.height; r++) {
+		if ((int)rows[r].size() != result.width)
+			throw invalid_argument("GridMap: the rows of the map file have different lengths");
+		const int y = result.height - 1 - r;	// The top row comes first
+		for (int x = 0; x < result.width; x++) {
+			const char c = rows[r][x];
+			if (c == '#')
+				result.walls[(size_t)(x + y * result.width) / 64] |= 1ULL << ((x + y * result.width) % 64);
+			else if (c == 'S') {
+				startX = x;
+				startY = y;
+			}
+			else if (c == 'G') {
+				goalX = x;
+				goalY = y;
+			}
+			else if ((c != '.') && (c != ' '))
+				throw invalid_argument(string("GridMap: unknown character '") + c + "' in the map file");
+		}
+	}
+	for (int y = 0; y < result.height; y++)
+		for (int x = 0; x < result.width; x++)
+			result.updateMoves(x, y);
+	result.setStart(startX, startY);
+	result.setGoal(goalX, goalY);
+	return result;
+}
+
+GridMap GridMap::loadBinary(istream & in) {
+	int32_t header[4];
+	in.read(reinterpret_cast<char *>(header), sizeof(header));
+	if (!in)
+		throw invalid_argument("GridMap: the binary map file is truncated");
+	GridMap result(header[0], header[1]);
+	in.read(reinterpret_cast<char *>(result.walls.data()), result.walls.size() * sizeof(unsigned long long));
+	if (!in)
+		throw invalid_argument("GridMap: the binary map file is truncated");
+	for (int y = 0; y < result.height; y++)
+		for (int x = 0; x < result.width; x++)
+			result.updateMoves(x, y);
+	if ((header[2] < 0) || (header[2] >= result.getNumCells()) || (header[3] < 0) || (header[3] >= result.getNumCells()))
+		throw invalid_argument("GridMap: the start or the goal of the binary map file is outside of the grid");
+	result.setStart(header[2] % result.width, header[2] / result.width);
+	result.setGoal(header[3] % result.width, header[3] / result.width);
+	return result;
+}
+
+void GridMap::saveBinary(const string & path) const {
+	ofstream out(path, ios::binary);
+	const int32_t header[4] = { width, height, start, goal };
+	out.write(gridMapMagic, sizeof(gridMapMagic));
+	out.write(reinterpret_cast<const char *>(header), sizeof(header));
+	out.write(reinterpret_cast<const char *>(walls.data()), walls.size() * sizeof(unsigned long long));
+	if (!out)
+		throw runtime_error("GridMap: cannot write " + path);
+}
+
+GridMap GridMap::random(const int & width, const int & height, const double & wallFraction, const unsigned long long & seed) {
+	GridMap result(width, height);
+	mt19937_64 generator(seed);
+	bernoulli_distribution isWall(wallFraction);
+	for (int y = 1; y < height; y++) {		// Not the bottom row
+		for (int x = 0; x + 1 < width; x++) {	// nor the right column
+			if (isWall(generator))
+				result.walls[(size_t)(x + y * width) / 64] |= 1ULL << ((x + y * width) % 64);
+		}
+	}
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			result.updateMoves(x, y);
+	return result;
+}
+
+void GridMap::setWall(const int & x, const int & y, const bool & wall) {
+	checkCell(x, y);
+	const int cell = x + y * width;
+	if (wall && ((cell == start) || (cell == goal)))
+		throw invalid_argument("GridMap: the start and the goal cannot be walls");
+	if (wall)
+		walls[cell / 64] |= 1ULL << (cell % 64);
+	else
+		walls[cell / 64] &= ~(1ULL << (cell % 64));
+	updateMoves(x, y);					// The cell, and the neighbors that can move into it
+	if (y + 1 < height)
+		updateMoves(x, y + 1);
+	if (y > 0)
+		updateMoves(x, y - 1);
+	if (x > 0)
+		updateMoves(x - 1, y);
+	if (x + 1 < width)
+		updateMoves(x + 1, y);
+}
+
+void GridMap::setStart(const int & x, const int & y) {
+	checkCell(x, y);
+	if (isWall(x, y))
+		throw invalid_argument("GridMap: the start cannot be a wall");
+	start = x + y * width;
+}
+
+void GridMap::setGoal(const int & x, const int & y) {
+	checkCell(x, y);
+	if (isWall(x, y))
+		throw invalid_argument("GridMap: the goal cannot be a wall");
+	goal = x + y * width;
+}
+
+int GridMap::getWidth() const {
+	return width;
+}
+
+int GridMap::getHeight() const {
+	return height;
+}
+
+int GridMap::getNumCells() const {
+	return width * height;
+}
+
+bool GridMap::isWall(const int & x, const int & y) const {
+	const int cell = x + y * width;
+	return (walls[cell / 64] >> (cell % 64)) & 1;
+}
+
+int GridMap::getStart() const {
+	return start;
+}
+
+int GridMap::getGoal() const {
+	return goal;
+}
+
+size_t GridMap::getMemory() const {
+	return sizeof(GridMap) + walls.capacity() * sizeof(unsigned long long) + moves.capacity();
+}
+
+void GridMap::updateMoves(const int & x, const int & y) {
+	int allowed = 0;
+	if ((y + 1 < height) && !isWall(x, y + 1))
+		allowed |= 1;
+	if ((y > 0) && !isWall(x, y - 1))
+		allowed |= 2;
+	if ((x > 0) && !isWall(x - 1, y))
+		allowed |= 4;
+	if ((x + 1 < width) && !isWall(x + 1, y))
+		allowed |= 8;
+	const int cell = x + y * width;
+	const int shift = (cell & 1) << 2;
+	moves[cell >> 1] = (unsigned char)((moves[cell >> 1] & ~(0xF << shift)) | (allowed << shift));
+}
+
+void GridMap::checkCell(const int & x, const int & y) const {
+	if ((x < 0) || (x >= width) || (y < 0) || (y >= height))
+		throw out_of_range("GridMap: cell outside of the grid");
+}
@@ -7,13 +7,23 @@ This file contains the implementations of all of the functions defined in the Gr
 */
 
 // Implement the constructor.
-Gridworld::Gridworld() {
+Gridworld::Gridworld() : Gridworld(make_shared<GridMap>(5, 5)) {}
+
+Gridworld::Gridworld(const shared_ptr<const GridMap> & map) : map(map) {
 	mt19937_64 generator(0);	// Initialize the RNG.
 	newEpisode(generator);		// Start a new episode.
 }
 
+const GridMap & Gridworld::getMap() const {
+	return *map;
+}
+
 int Gridworld::getStateDim() const {
-	return size*size;			// The state will be a tabular representation, implemented using linear function approxiamtion.
+	return map->getNumCells();	// The state will be a tabular representation, implemented using linear function approxiamtion.
+}
+
+int Gridworld::getNumStates() const {
+	return map->getNumCells();
 }
 
 int Gridworld::getNumActions() const {
@@ -21,30 +31,35 @@ int Gridworld::getNumActions() const {
 }
 
 double Gridworld::update(const int & action, mt19937_64 & generator) {
-	// Actions correspond to up/down/left/right, where (0,0) is bottom left. Actions always succeed
-	if (action == 0)
-		y++;
-	else if (action == 1)
-		y--;
-	else if (action == 2)
-		x--;
-	else
-		x++;
-	x = bound(x, 0, size - 1);	// The bound function is defined in MathUtils.hpp
-	y = bound(y, 0, size - 1);	
+	// Actions correspond to up/down/left/right, where (0,0) is bottom left. Actions succeed unless they would leave the grid or
+	// enter a wall, in which case the agent stays put. The map's transition table has the result (see GridMap.hpp).
+	cell = map->move(cell, action);
 	return -1;	// Reward is always -1
 }
 
 vector<double> Gridworld::getState(mt19937_64 & generator) {
-	vector<double> result(size*size, 0.0);	// Effective tabular representation, one element per state, all set to zero.
-	result[x + y*size] = 1.0;				// Set the s'th element to be 1, where we map x-y coordinates to unique integers.	
+	vector<double> result;
+	getState(generator, result);
 	return result;
 }
 
+void Gridworld::getState(mt19937_64 & generator, vector<double> & result) {
+	result.assign(map->getNumCells(), 0.0);	// Effective tabular representation, one element per state, all set to zero.
+	result[cell] = 1.0;						// Set the s'th element to be 1, where we map x-y coordinates to unique integers.
+}
+
+void Gridworld::getState(mt19937_64 & generator, SparseState & result) {
+	result.setOneHot(map->getNumCells(), cell);
+}
+
+void Gridworld::getState(mt19937_64 & generator, int & result) {
+	result = cell;
+}
+
 bool Gridworld::inTerminalState() const {
-	return ((x == size - 1) && (y == size - 1));	// Are we in state (size-1,size-1)?
+	return cell == map->getGoal();			// Are we in the goal cell?
 }
 
 void Gridworld::newEpisode(mt19937_64 & generator) {
-	x = y = 0;								// Always start in state (0,0).
-}
\ No newline at end of file
+	cell = map->getStart();					// Always start in the start cell.
+}
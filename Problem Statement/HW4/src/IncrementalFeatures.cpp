@@ -0,0 +1,127 @@
+#include "stdafx.h"
+
+using namespace std;
+
+IncrementalFeatures::IncrementalFeatures() : inputDimension(0), nTerms(0) {
+}
+
+IncrementalFeatures::IncrementalFeatures(const shared_ptr<const FourierBasis> & basis) {
+	reset(basis);
+}
+
+void IncrementalFeatures::reset(const shared_ptr<const FourierBasis> & basis) {
+	this->basis = basis;
+	inputDimension = basis->getInputDimension();
+	nTerms = basis->getNumOutputs();
+	basis->getCoefficientColumns(columnStart, columnTerm, columnCoefficient);
+	columnMaxCoefficient.assign(inputDimension, 0);
+	for (int k = 0; k < inputDimension; k++)
+		for (int e = columnStart[k]; e < columnStart[k + 1]; e++)
+			columnMaxCoefficient[k] = max(columnMaxCoefficient[k], columnCoefficient[e]);
+	const int maxCoefficient = *max_element(columnMaxCoefficient.begin(), columnMaxCoefficient.end());
+	// Size every buffer now, so that update never allocates
+	state.assign(inputDimension, 0.0);
+	features.assign(nTerms, 0.0);
+	sines.assign(nTerms, 0.0);
+	scratch.assign(max(nTerms, 2 * (maxCoefficient + 1)), 0.0);
+	rotationCos.assign(maxCoefficient + 1, 1.0);
+	rotationSin.assign(maxCoefficient + 1, 0.0);
+	changed.clear();
+	changed.reserve(inputDimension);
+	valid = sinesValid = false;
+	numIncrementalUpdates = numFullUpdates = 0;
+}
+
+const vector<double> & IncrementalFeatures::update(const vector<double> & x) {
+	if (!valid) {
+		recompute(x.data(), true);
+		return features;
+	}
+	// Cost of rotating, in cosines: 2*M for each changed input, plus the rotations of the nonzeros in its column
+	changed.clear();
+	long long cosines = 0, rotations = 0;
+	for (int k = 0; k < inputDimension; k++) {
+		if (x[k] != state[k]) {
+			changed.push_back(k);
+			cosines += 2 * columnMaxCoefficient[k];
+			rotations += columnStart[k + 1] - columnStart[k];
+		}
+	}
+	const bool worthRotating = (cosines + rotations / rotationsPerCosine <= nTerms);
+	if (worthRotating && sinesValid && (updatesSinceRefresh < refreshInterval)) {
+		for (int k : changed) {
+			rotateColumn(k, x[k] - state[k]);
+			state[k] = x[k];
+		}
+		updatesSinceRefresh++;
+		numIncrementalUpdates++;
+	}
+	else if (worthRotating)
+		recompute(x.data(), true);		// The next steps rotate from here, so they need the sines
+	else {
+		// Rotating does not pay off, so this step is basify itself, with its harmonic recurrence and coefficient layouts. The sines
+		// are left out and computed by the first recompute after which rotating pays off again.
+		copy(x.begin(), x.end(), state.begin());
+		basis->basify(x, features);
+		valid = true;
+		sinesValid = false;
+		updatesSinceRefresh = 0;
+		numFullUpdates++;
+	}
+	return features;
+}
+
+void IncrementalFeatures::recompute(const double * x, const bool & withSines) {
+	copy(x, x + inputDimension, state.begin());
+	basis->getArguments(x, scratch.data());
+	cosPi(scratch.data(), features.data(), nTerms, basis->getCosineMode());
+	if (withSines) {
+		for (int i = 0; i < nTerms; i++)
+			scratch[i] -= 0.5;						// sin(pi*t) = cos(pi*(t - 1/2))
+		cosPi(scratch.data(), sines.data(), nTerms, basis->getCosineMode());
+	}
+	valid = true;
+	sinesValid = withSines;
+	updatesSinceRefresh = 0;
+	numFullUpdates++;
+}
+
+void IncrementalFeatures::rotateColumn(const int & k, const double & dx) {
+	const int maxCoefficient = columnMaxCoefficient[k];
+	// The angles pi*m*dx and pi*m*dx - pi/2 for m = 1..maxCoefficient, then their cosines in one pass
+	for (int m = 1; m <= maxCoefficient; m++) {
+		scratch[m - 1] = (double)m * dx;
+		scratch[maxCoefficient + m - 1] = (double)m * dx - 0.5;
+	}
+	cosPi(scratch.data(), scratch.data(), 2 * maxCoefficient, basis->getCosineMode());
+	for (int m = 1; m <= maxCoefficient; m++) {
+		rotationCos[m] = scratch[m - 1];
+		rotationSin[m] = scratch[maxCoefficient + m - 1];
+	}
+	for (int e = columnStart[k]; e < columnStart[k + 1]; e++) {
+		const int i = columnTerm[e], m = columnCoefficient[e];
+		const double c = features[i], s = sines[i];
+		features[i] = c * rotationCos[m] - s * rotationSin[m];
+		sines[i] = s * rotationCos[m] + c * rotationSin[m];
+	}
+}
+
+const vector<double> & IncrementalFeatures::getFeatures() const {
+	return features;
+}
+
+void IncrementalFeatures::invalidate() {
+	valid = false;
+}
+
+void IncrementalFeatures::setRefreshInterval(const int & interval) {
+	refreshInterval = max(1, interval);
+}
+
+long long IncrementalFeatures::getNumIncrementalUpdates() const {
+	return numIncrementalUpdates;
+}
+
+long long IncrementalFeatures::getNumFullUpdates() const {
+	return numFullUpdates;
+}
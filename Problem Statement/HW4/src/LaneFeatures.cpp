@@ -0,0 +1,59 @@
+#include "stdafx.h"
+
+using namespace std;
+
+LaneFeatures::LaneFeatures() : numLanes(0), numFeatures(0) {}
+
+void LaneFeatures::resize(const int & numLanes, const int & numFeatures) {
+	this->numLanes = numLanes;
+	this->numFeatures = numFeatures;
+	features.assign((size_t)numLanes * numFeatures, 0.0);
+}
+
+void LaneFeatures::basify(const FourierBasis & fb, const double * states, const unsigned char * lanes) {
+	const int stateDim = fb.getInputDimension();
+	int count = 0;
+	for (int k = 0; k < numLanes; k++)
+		count += (lanes[k] != 0);
+	if (count == numLanes) {
+		fb.basifyBatch(states, numLanes, features.data());
+		return;
+	}
+	if (count == 0)
+		return;
+	gatheredStates.resize((size_t)count * stateDim);
+	gatheredFeatures.resize((size_t)count * numFeatures);
+	for (int k = 0, n = 0; k < numLanes; k++) {
+		if (lanes[k]) {
+			copy(states + (size_t)k * stateDim, states + (size_t)(k + 1) * stateDim, gatheredStates.begin() + (size_t)n * stateDim);
+			n++;
+		}
+	}
+	fb.basifyBatch(gatheredStates.data(), count, gatheredFeatures.data());
+	for (int k = 0, n = 0; k < numLanes; k++) {
+		if (lanes[k]) {
+			copy(gatheredFeatures.begin() + (size_t)n * numFeatures, gatheredFeatures.begin() + (size_t)(n + 1) * numFeatures, features.begin() + (size_t)k * numFeatures);
+			n++;
+		}
+	}
+}
+
+double * LaneFeatures::lane(const int & k) {
+	return features.data() + (size_t)k * numFeatures;
+}
+
+const double * LaneFeatures::lane(const int & k) const {
+	return features.data() + (size_t)k * numFeatures;
+}
+
+void LaneFeatures::swap(LaneFeatures & other) {
+	std::swap(numLanes, other.numLanes);
+	std::swap(numFeatures, other.numFeatures);
+	features.swap(other.features);
+	gatheredStates.swap(other.gatheredStates);
+	gatheredFeatures.swap(other.gatheredFeatures);
+}
+
+size_t LaneFeatures::getMemory() const {
+	return (features.capacity() + gatheredStates.capacity() + gatheredFeatures.capacity()) * sizeof(double);
+}
@@ -0,0 +1,100 @@
+#include "stdafx.h"
+
+using namespace std;
+
+LockstepQLearning::LockstepQLearning(const int & numLanes, const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & iOrder, const int & dOrder, const int & coupledTermBudget)
+	: LockstepQLearning(stateDim, numActions, vector<double>(max(numLanes, 0), alpha), gamma, vector<double>(max(numLanes, 0), epsilon), iOrder, dOrder, coupledTermBudget) {}
+
+LockstepQLearning::LockstepQLearning(const int & stateDim, const int & numActions, const vector<double> & alphas, const double & gamma, const vector<double> & epsilons, const int & iOrder, const int & dOrder, const int & coupledTermBudget) : numLanes((int)alphas.size()), numActions(numActions), alphas(alphas), gamma(gamma) {
+	if (numActions > maxNumActions)
+		throw invalid_argument("LockstepQLearning supports at most maxNumActions actions");
+	if (numLanes < 1)
+		throw invalid_argument("LockstepQLearning needs at least one lane");
+	if (epsilons.size() != alphas.size())
+		throw invalid_argument("LockstepQLearning needs one epsilon per lane");
+	shared_ptr<FourierBasis> basis = make_shared<FourierBasis>();
+	basis->init(stateDim, iOrder, dOrder, coupledTermBudget);
+	fb = basis;
+	numFeatures = fb->getNumOutputs();
+	w.resize(numLanes * numActions, numFeatures);
+	phi.resize(numLanes, numFeatures);
+	phiNext.resize(numLanes, numFeatures);
+	nonterminal.resize(numLanes);
+	laneQ.resize(numLanes);
+	qReady.assign(numLanes, 0);
+	for (int k = 0; k < numLanes; k++)
+		d1.push_back(bernoulli_distribution(epsilons[k]));
+	d2 = uniform_int_distribution<int>(0, numActions - 1);
+}
+
+int LockstepQLearning::getNumLanes() const {
+	return numLanes;
+}
+
+void LockstepQLearning::newEpisode(const unsigned char * lanes, const double * states) {
+	phi.basify(*fb, states, lanes);
+	for (int k = 0; k < numLanes; k++) {
+		if (lanes[k])
+			qReady[k] = 0;
+	}
+}
+
+void LockstepQLearning::getActions(const unsigned char * active, mt19937_64 * generators, int * actions) {
+	for (int k = 0; k < numLanes; k++) {
+		if (!active[k])
+			continue;
+		if (d1[k](generators[k])) {
+			actions[k] = d2(generators[k]);
+			continue;
+		}
+		if (!qReady[k]) {	// Only at the start of an episode: otherwise train computed q(s,.) when s was s'
+			for (int a = 0; a < numActions; a++)
+				laneQ[k][a] = dotProduct(w.row(k * numActions + a), phi.lane(k), numFeatures);
+			qReady[k] = 1;
+		}
+		actions[k] = greedyAction(laneQ[k], numActions, generators[k]);
+	}
+}
+
+// QLearning::train, lane by lane: TDerror = r + gamma*max_a' q(s',a') - q(s,a) (r - q(s,a) if s' is terminal), w[a] += alpha*TDerror*phi(s).
+void LockstepQLearning::train(const unsigned char * active, const int * actions, const double * rewards, const double * nextStates, const unsigned char * terminal) {
+	for (int k = 0; k < numLanes; k++)
+		nonterminal[k] = active[k] && !terminal[k];
+	phiNext.basify(*fb, nextStates, nonterminal.data());
+	for (int k = 0; k < numLanes; k++) {
+		if (!active[k])
+			continue;
+		double * wa = w.row(k * numActions + actions[k]);
+		double TDerror;
+		if (terminal[k])
+			TDerror = rewards[k] - dotProduct(wa, phi.lane(k), numFeatures);
+		else {
+			QValues & q = laneQ[k];
+			for (int a = 0; a < numActions; a++)
+				q[a] = dotProduct(w.row(k * numActions + a), phiNext.lane(k), numFeatures);
+			TDerror = rewards[k] + gamma * maxQValue(q, numActions) - dotProduct(wa, phi.lane(k), numFeatures);
+		}
+		addScaled(alphas[k] * TDerror, phi.lane(k), wa, numFeatures);
+		qReady[k] = !terminal[k];
+		if (qReady[k])		// Keep the kept q(s',a) up to date with the new weights, as QLearning's StepCache does
+			laneQ[k][actions[k]] = dotProduct(wa, phiNext.lane(k), numFeatures);
+	}
+	for (int k = 0; k < numLanes; k++) {	// s' becomes s. The inactive lanes keep their s, and the terminal ones get a new one from newEpisode.
+		if (!active[k])
+			copy(phi.lane(k), phi.lane(k) + numFeatures, phiNext.lane(k));
+	}
+	phi.swap(phiNext);
+}
+
+double LockstepQLearning::getQ(const int & k, const int & a) const {
+	return dotProduct(w.row(k * numActions + a), phi.lane(k), numFeatures);
+}
+
+size_t LockstepQLearning::getTrialMemory() const {
+	return sizeof(LockstepQLearning) + w.getMemory() + phi.getMemory() + phiNext.getMemory() + nonterminal.capacity()
+		+ alphas.capacity() * sizeof(double) + d1.capacity() * sizeof(bernoulli_distribution) + laneQ.capacity() * sizeof(QValues) + qReady.capacity();
+}
+
+size_t LockstepQLearning::getSharedMemory() const {
+	return fb->getMemory();
+}
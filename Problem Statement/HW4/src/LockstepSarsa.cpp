@@ -0,0 +1,122 @@
+#include "stdafx.h"
+
+using namespace std;
+
+LockstepSarsa::LockstepSarsa(const int & numLanes, const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & iOrder, const int & dOrder, const int & coupledTermBudget)
+	: LockstepSarsa(stateDim, numActions, vector<double>(max(numLanes, 0), alpha), gamma, vector<double>(max(numLanes, 0), epsilon), iOrder, dOrder, coupledTermBudget) {}
+
+LockstepSarsa::LockstepSarsa(const int & stateDim, const int & numActions, const vector<double> & alphas, const double & gamma, const vector<double> & epsilons, const int & iOrder, const int & dOrder, const int & coupledTermBudget) : numLanes((int)alphas.size()), numActions(numActions), alphas(alphas), gamma(gamma) {
+	if (numActions > maxNumActions)
+		throw invalid_argument("LockstepSarsa supports at most maxNumActions actions");
+	if (numLanes < 1)
+		throw invalid_argument("LockstepSarsa needs at least one lane");
+	if (epsilons.size() != alphas.size())
+		throw invalid_argument("LockstepSarsa needs one epsilon per lane");
+	shared_ptr<FourierBasis> basis = make_shared<FourierBasis>();
+	basis->init(stateDim, iOrder, dOrder, coupledTermBudget);
+	fb = basis;
+	numFeatures = fb->getNumOutputs();
+	w.resize(numLanes * numActions, numFeatures);
+	phi_s.resize(numLanes, numFeatures);
+	phi.resize(numLanes, numFeatures);
+	phiNext.resize(numLanes, numFeatures);
+	nonterminal.resize(numLanes);
+	for (int k = 0; k < numLanes; k++)
+		d1.push_back(bernoulli_distribution(epsilons[k]));
+	d2 = uniform_int_distribution<int>(0, numActions - 1);
+	flag.assign(numLanes, 0);
+	laneQ.resize(numLanes);
+	qReady.assign(numLanes, 0);
+	previous_a.assign(numLanes, 0);
+	previous_r.assign(numLanes, 0.0);
+}
+
+int LockstepSarsa::getNumLanes() const {
+	return numLanes;
+}
+
+void LockstepSarsa::newEpisode(const unsigned char * lanes, const double * states) {
+	phi.basify(*fb, states, lanes);
+	for (int k = 0; k < numLanes; k++) {
+		if (lanes[k])
+			flag[k] = qReady[k] = 0;
+	}
+}
+
+void LockstepSarsa::getActions(const unsigned char * active, mt19937_64 * generators, int * actions) {
+	for (int k = 0; k < numLanes; k++) {
+		if (!active[k])
+			continue;
+		if (d1[k](generators[k])) {
+			actions[k] = d2(generators[k]);
+			continue;
+		}
+		loadQ(k);
+		actions[k] = greedyAction(laneQ[k], numActions, generators[k]);
+	}
+}
+
+void LockstepSarsa::loadQ(const int & k) {
+	if (qReady[k])
+		return;
+	for (int a = 0; a < numActions; a++)
+		laneQ[k][a] = dotProduct(w.row(k * numActions + a), phi.lane(k), numFeatures);
+	qReady[k] = 1;
+}
+
+// Sarsa::train, lane by lane: the previous (s, a, r) is updated towards r + gamma*q(s,a), and (s, a) itself when s' is terminal.
+void LockstepSarsa::train(const unsigned char * active, const int * actions, const double * rewards, const double * nextStates, const unsigned char * terminal) {
+	for (int k = 0; k < numLanes; k++)
+		nonterminal[k] = active[k] && !terminal[k];
+	phiNext.basify(*fb, nextStates, nonterminal.data());
+	for (int k = 0; k < numLanes; k++) {
+		if (!active[k])
+			continue;
+		const int a = actions[k];
+		double * wa = w.row(k * numActions + a);
+		if (flag[k]) {
+			QValues & q = laneQ[k];	// q(s,.), usually already computed by getActions
+			loadQ(k);
+			double * wPrevious = w.row(k * numActions + previous_a[k]);
+			double term3 = dotProduct(wPrevious, phi_s.lane(k), numFeatures);
+			double term2 = gamma * q[a];
+			double TDerror = previous_r[k] + term2 - term3;
+			addScaled(alphas[k] * TDerror, phi_s.lane(k), wPrevious, numFeatures);
+			q[previous_a[k]] = dotProduct(wPrevious, phi.lane(k), numFeatures);
+
+			if (terminal[k]) {
+				double term3 = q[a];
+				double term2 = gamma * 0.0;
+				double TDerror = rewards[k] + term2 - term3;
+				addScaled(alphas[k] * TDerror, phi.lane(k), wa, numFeatures);
+			}
+		}
+		qReady[k] = 0;	// s' becomes s
+		flag[k] = 1;
+		previous_a[k] = a;
+		previous_r[k] = rewards[k];
+	}
+	// phi_s <- phi <- phiNext. The inactive lanes keep their rows, and the terminal ones get a new phi from newEpisode.
+	for (int k = 0; k < numLanes; k++) {
+		if (!active[k]) {
+			copy(phi.lane(k), phi.lane(k) + numFeatures, phiNext.lane(k));
+			copy(phi_s.lane(k), phi_s.lane(k) + numFeatures, phi.lane(k));
+		}
+	}
+	phi_s.swap(phi);
+	phi.swap(phiNext);
+}
+
+double LockstepSarsa::getQ(const int & k, const int & a) const {
+	return dotProduct(w.row(k * numActions + a), phi.lane(k), numFeatures);
+}
+
+size_t LockstepSarsa::getTrialMemory() const {
+	return sizeof(LockstepSarsa) + w.getMemory() + phi_s.getMemory() + phi.getMemory() + phiNext.getMemory() + nonterminal.capacity()
+		+ alphas.capacity() * sizeof(double) + d1.capacity() * sizeof(bernoulli_distribution)
+		+ flag.capacity() + previous_a.capacity() * sizeof(int) + previous_r.capacity() * sizeof(double) + laneQ.capacity() * sizeof(QValues) + qReady.capacity();
+}
+
+size_t LockstepSarsa::getSharedMemory() const {
+	return fb->getMemory();
+}
@@ -2,18 +2,20 @@
 
 using namespace std;
 
+constexpr int MountainCar::stateDim;
+constexpr int MountainCar::numActions;
+
 MountainCar::MountainCar() {
-	state.resize(2);
 	mt19937_64 generator(0);
 	newEpisode(generator);
 }
 
 int MountainCar::getStateDim() const {
-	return 2;
+	return stateDim;
 }
 
 int MountainCar::getNumActions() const {
-	return 3;
+	return numActions;
 }
 
 double MountainCar::update(const int & action, mt19937_64 & generator) {
@@ -31,10 +33,23 @@ double MountainCar::update(const int & action, mt19937_64 & generator) {
 }
 
 vector<double> MountainCar::getState(mt19937_64 & generator) {
-	vector<double> result(2);
+	vector<double> result;
+	getState(generator, result);
+	return result;
+}
+
+void MountainCar::getState(mt19937_64 & generator, vector<double> & result) {
+	result.resize(stateDim);
+	writeState(result.data());
+}
+
+void MountainCar::getState(mt19937_64 & generator, State & result) {
+	writeState(result.data());
+}
+
+void MountainCar::writeState(double * result) const {
 	result[0] = normalize(state[0], minX, maxX);
 	result[1] = normalize(state[1], minXDot, maxXDot);
-	return result;
 }
 
 bool MountainCar::inTerminalState() const {
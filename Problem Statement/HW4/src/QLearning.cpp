@@ -3,20 +3,24 @@
 using namespace std;
 
 // This constructor is called whenever a QLearning object is created. The bit at the end of the line below initializes the private member variables to be the values provided as arguments.
-QLearning::QLearning(const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & iOrder, const int & dOrder) : stateDim(stateDim), numActions(numActions), alpha(alpha), gamma(gamma) {
-	// Initialize the FourierBasis, computing the C-matrix.
-	fb.init(stateDim, iOrder, dOrder);
+QLearning::QLearning(const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & iOrder, const int & dOrder, const int & coupledTermBudget) : stateDim(stateDim), numActions(numActions), alpha(alpha), gamma(gamma) {
+	// The q-value kernels keep one value per action on the stack (see QValues.hpp).
+	if (numActions > maxNumActions)
+		throw invalid_argument("QLearning supports at most maxNumActions actions");
+
+	// Initialize the FourierBasis, computing the C-matrix. From here on it is read-only, and shared by every copy of this agent.
+	shared_ptr<FourierBasis> basis = make_shared<FourierBasis>();
+	basis->init(stateDim, iOrder, dOrder, coupledTermBudget);
+	fb = basis;
 
 	// Get the number of features the FourierBasis will output given the specified stateDim, iOrder, and dOrder
-	numFeatures = fb.getNumOutputs();
+	numFeatures = fb->getNumOutputs();
 
-	// Initialize the weights to be a vector of numActions vectors, each of which has numFeatures elements, all initially zero.
-	w.resize(numActions);
-	for (int a = 0; a < numActions; a++)
-		w[a] = vector<double>(numFeatures, 0.0);
+	// Initialize the weights to be a numActions x numFeatures matrix, all initially zero.
+	w.resize(numActions, numFeatures);
 
-	// Initialize phi (which is phi(s)) and phiPrime (which is phi(sPrime)) to be of length numFeatures, and equal to zero
-	phiPrime = phi = vector<double>(numFeatures, 0.0);
+	// Initialize phi (which is phi(s)) to be of length numFeatures, and equal to zero
+	phi = vector<double>(numFeatures, 0.0);
 
 	// Set d1 to be a Bernoulli that returns true with probability epsilon.
 	d1 = bernoulli_distribution(epsilon);
@@ -27,38 +31,29 @@ QLearning::QLearning(const int & stateDim, const int & numActions, const double
 
 // Train given an (s,a,r,s') tuple. We won't be using the generator here, since the QLearning update is not random. If sPrimeTerminal==true, then after this call to train, "newEpisode" will be called - we will not train with s set to what is sPrime right now, as all subsequent rewards would be zero.
 void QLearning::train(std::mt19937_64 & generator, const std::vector<double> & s, const int & a, double & r, const std::vector<double> & sPrime, const bool & sPrimeTerminal) {
-	// If we haven't initialized phi, initialize it and set the flag for phiInit.
-	if (!phiInit) {
-		phi = fb.basify(s);	// fb.basify(s) returns the features for state s.
-		phiInit = true;
-	}
-
-	// we know q(terminal_state, any_action) = 0.
-	if (!sPrimeTerminal) {
-		phiPrime = fb.basify(sPrime);		// Get phi(sPrime)
+	// Get phi(s). It is normally cached, as sPrime of the previous call to train (or from getAction, at the start of an episode):
+	// take the cached buffer instead of copying it. The cache gets our old buffer to basify sPrime into.
+	if (cache.holds(s))
+		cache.swapOutPhi(phi);
+	else
+		basify(s, phi);			// basify(s, phi) stores the features for state s in phi.
+
+	// Compute the TD-error. We know q(terminal_state, any_action) = 0. Otherwise, get phi(sPrime) and max_a q(sPrime,a) through the cache,
+	// so that the next call to getAction(sPrime) does not have to compute them again.
+	double TDerror;
+	if (sPrimeTerminal)
+		TDerror = r - w.dot(a, phi);
+	else {
+		loadCache(sPrime);
+		TDerror = r + gamma * maxQValue(cache.getQ(), numActions) - w.dot(a, phi);
 	}
-	
-	// TODO: Put your code here for QLearning's update. Hint: you may want to compute the TD error first, then perform the update.
-	// Another hint: How you compute the TD-error should likely depend on whether sPrimeTerminal is true!
-	// I'm leaving in part of my solution, which makes it clear how I intended for phi and phiPrime to be loaded. For me, this code
-	// was within the first step - computing the TD-error. You probably shouldn't be calling fb.basify(sPrime) if sPrimeTerminal == true, since
-
-	double TDerror = r + gamma * maxQ(phiPrime) - dot(w[a], phi);
 
-	if(sPrimeTerminal == true) TDerror = r - dot(w[a], phi);
-
-	for(int i = 0; i < (int)w[a].size(); i++) w[a][i] += alpha * TDerror * phi[i];
-
-	// Your code should probably all be above this comment.
-	
-	// We computed phi(sPrime). Store that in phi, as this will be phi(s) next time train is called.
-	phi = phiPrime;
+	w.addScaled(a, alpha * TDerror, phi);	// w[a] += alpha*TDerror*phi, vectorized
+	cache.refresh(w, a);	// Keep the cached q(sPrime,a) up to date with the new weights
 }
 
 void QLearning::newEpisode(mt19937_64 & generator) {
-	// Note that phi has not been initialized during the previous call to train, as this is a new episode and the next
-	// call to train will be the first of the episode.
-	phiInit = false;
+	// Nothing to reset: phi(s) is looked up by state in train, and the cache is always consistent with the weights.
 }
 
 int QLearning::getAction(const std::vector<double> & s, std::mt19937_64 & generator) {
@@ -66,29 +61,72 @@ int QLearning::getAction(const std::vector<double> & s, std::mt19937_64 & genera
 	if (d1(generator))
 		return d2(generator);	// Explore. d2(generator) returns a uniform-random number from 0 to numActions-1 (see the constructor for where this distribution object was initialized)
 
-	// We should act greedily. First, convert s to features (we don't call these "phi", since that is a member variable that we don't want to over-write).
-	vector<double> features = fb.basify(s);
-	vector<int> bestActions(1, 0);	// Create a vector to store the best actions we have found so far. Put in action a=0.
-	double bestActionValue = dot(w[0],features);		// Get q(s,0), and store in bestActionValue.
-	for (int a = 1; a < numActions; a++) {				// Loop over actions, starting with a=1, and see if it is better than our currently stored bestActionValue
-		double curActionValue = dot(w[a], features);	// Get q(s,a)
-		if (curActionValue == bestActionValue)			// if q(s,a) == bestActionValue
-			bestActions.push_back(a);						// Append action a to the list of best actions
-		else if (curActionValue > bestActionValue) {	// if q(s,a) > bestActionValue
-			bestActionValue = curActionValue;				// Set bestActionValue to be q(s,a)
-			bestActions.resize(1);							// Empty out bestActions to only have one element
-			bestActions[0] = a;								// Set that one element to be action a.
-		}
+	// We should act greedily. Get q(s,a) for every action, then pick the best action, breaking ties at random (see QValues.hpp).
+	// This is usually a cache hit: train computed q(s,.) when s was sPrime.
+	loadCache(s);
+	return greedyAction(cache.getQ(), numActions, generator);
+}
+
+// The same as train above, with sparse features and weights.
+void QLearning::train(std::mt19937_64 & generator, const SparseState & s, const int & a, double & r, const SparseState & sPrime, const bool & sPrimeTerminal) {
+	initSparseWeights();
+	if (sparseCache.holds(s))
+		sparseCache.swapOutPhi(sparsePhi);
+	else
+		fb->basify(s, sparsePhi);
+
+	double TDerror;
+	if (sPrimeTerminal)
+		TDerror = r - sparseW.dot(a, sparsePhi);
+	else {
+		sparseCache.load(*fb, sPrime, sparseW);
+		TDerror = r + gamma * maxQValue(sparseCache.getQ(), numActions) - sparseW.dot(a, sparsePhi);
 	}
-	if ((int)bestActions.size() == 1)					// Is there only one best action?
-		return bestActions[0];								// If so, return it. This is the most common case, and avoids using a random number generator most of the time.
-	return (uniform_int_distribution<int>(0, (int)bestActions.size() - 1))(generator);	// There are many best actions. Select one uniformly randomly from bestActions.
+
+	sparseW.addScaled(a, alpha * TDerror, sparsePhi);
+	sparseCache.refresh(sparseW, a);
+}
+
+int QLearning::getAction(const SparseState & s, std::mt19937_64 & generator) {
+	if (d1(generator))
+		return d2(generator);
+	initSparseWeights();
+	sparseCache.load(*fb, s, sparseW);
+	return greedyAction(sparseCache.getQ(), numActions, generator);
 }
 
-// Return max_{a \in \mathcal A} q(s,a), where phi is phi(s).
-double QLearning::maxQ(const vector<double> & phi) const {
-	double result = dot(w[0], phi);				// Start with q(s,0)
-	for (int a = 1; a < numActions; a++)		// Loop over actions a, starting with action 1
-		result = max(result, dot(w[a],phi));	// Set our current max value to be the max of our previous max value and q(s,a).
-	return result;								// Return the max value that we found.
-}
\ No newline at end of file
+void QLearning::initSparseWeights() {
+	if (sparseW.getNumRows() == 0)
+		sparseW.assign(w);
+}
+
+size_t QLearning::getTrialMemory() const {
+	return sizeof(QLearning) + w.getMemory() + phi.capacity() * sizeof(double) + cache.getMemory() + featureCache.getMemory()
+		+ sparseW.getMemory() + sparsePhi.getMemory() + sparseCache.getMemory();
+}
+
+size_t QLearning::getSharedMemory() const {
+	return fb->getMemory();
+}
+
+void QLearning::enableFeatureCache(const int & capacity, const vector<double> & cellSize) {
+	featureCache.reset(fb, capacity, cellSize);
+}
+
+const FeatureCache & QLearning::getFeatureCache() const {
+	return featureCache;
+}
+
+void QLearning::basify(const vector<double> & s, vector<double> & result) {
+	if (featureCache.isEnabled())
+		featureCache.basify(s, result);
+	else
+		fb->basify(s, result);
+}
+
+void QLearning::loadCache(const vector<double> & s) {
+	if (featureCache.isEnabled())
+		cache.load(featureCache, s, w);
+	else
+		cache.load(*fb, s, w);
+}
@@ -0,0 +1,136 @@
+#include "stdafx.h"
+
+using namespace std;
+
+QTable::QTable() : numStates(0), numActions(0) {}
+
+void QTable::resize(const int & numStates, const int & numActions) {
+	this->numStates = numStates;
+	this->numActions = numActions;
+	data.assign((size_t)numStates * numActions, 0.0);
+}
+
+int QTable::getNumStates() const {
+	return numStates;
+}
+
+int QTable::getNumActions() const {
+	return numActions;
+}
+
+double * QTable::row(const int & s) {
+	return data.data() + (size_t)s * numActions;
+}
+
+const double * QTable::row(const int & s) const {
+	return data.data() + (size_t)s * numActions;
+}
+
+long long QTable::getNumGrowths() const {
+	return 0;
+}
+
+size_t QTable::getMemory() const {
+	return data.capacity() * sizeof(double);
+}
+
+const int PagedQTable::pageBits;
+const int PagedQTable::pageStates;
+
+PagedQTable::PagedQTable() : numStates(0), numActions(0), pageSize(0), numPages(0), numGrowths(0), lastPage(-1), lastPosition(-1) {}
+
+void PagedQTable::resize(const int & numStates, const int & numActions) {
+	this->numStates = numStates;
+	this->numActions = numActions;
+	pageSize = pageStates * numActions;
+	numPages = 0;
+	AlignedVector().swap(pool);
+	directoryPage.assign(16, -1);
+	directoryPosition.assign(16, -1);
+	zeros.assign(numActions, 0.0);
+	numGrowths = 0;
+	lastPage = lastPosition = -1;
+}
+
+int PagedQTable::getNumStates() const {
+	return numStates;
+}
+
+int PagedQTable::getNumActions() const {
+	return numActions;
+}
+
+double * PagedQTable::row(const int & s) {
+	const int page = s >> pageBits;
+	int position = findPage(page);
+	if (position < 0) {
+		if ((size_t)(numPages + 1) * pageSize > pool.capacity()) {	// Grow the pool, keeping the pages where they are in it
+			pool.reserve(max((size_t)(numPages + 1) * pageSize, 2 * pool.capacity()));
+			numGrowths++;
+		}
+		pool.resize((size_t)(numPages + 1) * pageSize, 0.0);
+		if (2 * (numPages + 1) > (int)directoryPage.size())		// Keep the directory at most half full
+			growDirectory();
+		position = numPages++;
+		const int slot = directorySlot(page);
+		directoryPage[slot] = page;
+		directoryPosition[slot] = position;
+		lastPage = page;
+		lastPosition = position;
+	}
+	return pool.data() + (size_t)position * pageSize + (size_t)(s & (pageStates - 1)) * numActions;
+}
+
+const double * PagedQTable::row(const int & s) const {
+	const int position = findPage(s >> pageBits);
+	if (position < 0)
+		return zeros.data();
+	return pool.data() + (size_t)position * pageSize + (size_t)(s & (pageStates - 1)) * numActions;
+}
+
+int PagedQTable::getNumPages() const {
+	return numPages;
+}
+
+long long PagedQTable::getNumGrowths() const {
+	return numGrowths;
+}
+
+size_t PagedQTable::getMemory() const {
+	return pool.capacity() * sizeof(double) + (directoryPage.capacity() + directoryPosition.capacity()) * sizeof(int) + zeros.capacity() * sizeof(double);
+}
+
+int PagedQTable::findPage(const int & page) const {
+	if (page == lastPage)
+		return lastPosition;
+	const int slot = directorySlot(page);
+	if (directoryPage[slot] < 0)
+		return -1;
+	lastPage = page;
+	lastPosition = directoryPosition[slot];
+	return lastPosition;
+}
+
+int PagedQTable::directorySlot(const int & page) const {
+	const unsigned int mask = (unsigned int)directoryPage.size() - 1;
+	unsigned int slot = ((unsigned int)page * 0x9E3779B1u) & mask;	// Fibonacci hashing spreads consecutive pages apart
+	while ((directoryPage[slot] >= 0) && (directoryPage[slot] != page))
+		slot = (slot + 1) & mask;	// Linear probing. The directory is never full, so this terminates.
+	return (int)slot;
+}
+
+void PagedQTable::growDirectory() {
+	vector<int> oldPage, oldPosition;
+	oldPage.swap(directoryPage);
+	oldPosition.swap(directoryPosition);
+	directoryPage.assign(2 * oldPage.size(), -1);
+	directoryPosition.assign(2 * oldPage.size(), -1);
+	for (size_t slot = 0; slot < oldPage.size(); slot++) {
+		if (oldPage[slot] >= 0) {
+			const int newSlot = directorySlot(oldPage[slot]);
+			directoryPage[newSlot] = oldPage[slot];
+			directoryPosition[newSlot] = oldPosition[slot];
+		}
+	}
+	numGrowths++;
+}
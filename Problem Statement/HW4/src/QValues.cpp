@@ -0,0 +1,163 @@
+#include "stdafx.h"
+
+using namespace std;
+
+void computeQValues(const vector<double> & phi, const WeightMatrix & w, QValues & q) {
+	for (int a = 0; a < w.getNumRows(); a++)
+		q[a] = w.dot(a, phi);
+}
+
+double maxQValue(const QValues & q, const int & numActions) {
+	return maxQValue(q.data(), numActions);
+}
+
+double maxQValue(const double * q, const int & numActions) {
+	double result = q[0];
+	for (int a = 1; a < numActions; a++)
+		result = max(result, q[a]);
+	return result;
+}
+
+int greedyAction(const QValues & q, const int & numActions, mt19937_64 & generator) {
+	return greedyAction(q.data(), numActions, generator);
+}
+
+int greedyAction(const double * q, const int & numActions, mt19937_64 & generator) {
+	int numBest = 1;	// Number of actions tied for the largest value
+	int bestAction = 0;
+	double bestActionValue = q[0];
+	for (int a = 1; a < numActions; a++) {
+		if (q[a] == bestActionValue)
+			numBest++;
+		else if (q[a] > bestActionValue) {
+			bestActionValue = q[a];
+			bestAction = a;
+			numBest = 1;
+		}
+	}
+	if (numBest == 1)
+		return bestAction;
+	// Like the original getAction, return the uniformly drawn position in the list of tied actions (not the action at that position).
+	// This is kept as-is so that results stay reproducible against earlier runs.
+	return (uniform_int_distribution<int>(0, numBest - 1))(generator);
+}
+
+bool StepCache::load(const FourierBasis & fb, const vector<double> & s, const WeightMatrix & w) {
+	if (holds(s))
+		return true;
+	state = s;
+	fb.basify(s, phi);
+	computeQValues(phi, w, q);
+	valid = true;
+	return false;
+}
+
+bool StepCache::load(FeatureCache & features, const vector<double> & s, const WeightMatrix & w) {
+	if (holds(s))
+		return true;
+	state = s;
+	features.basify(s, phi);
+	computeQValues(phi, w, q);
+	valid = true;
+	return false;
+}
+
+bool StepCache::holds(const vector<double> & s) const {
+	return valid && (s == state);
+}
+
+void StepCache::refresh(const WeightMatrix & w, const int & a) {
+	if (valid)
+		q[a] = w.dot(a, phi);
+}
+
+void StepCache::swapOutPhi(vector<double> & buffer) {
+	phi.swap(buffer);
+	valid = false;
+}
+
+const vector<double> & StepCache::getPhi() const {
+	return phi;
+}
+
+const QValues & StepCache::getQ() const {
+	return q;
+}
+
+size_t StepCache::getMemory() const {
+	return (state.capacity() + phi.capacity()) * sizeof(double);
+}
+
+bool TileStepCache::load(const TileCoding & tc, const vector<double> & s, const WeightMatrix & w) {
+	if (holds(s))
+		return true;
+	state = s;
+	tc.basify(s, active);
+	for (int a = 0; a < w.getNumRows(); a++)
+		q[a] = w.sumAt(a, active.data(), (int)active.size());
+	valid = true;
+	return false;
+}
+
+bool TileStepCache::holds(const vector<double> & s) const {
+	return valid && (s == state);
+}
+
+void TileStepCache::refresh(const WeightMatrix & w, const int & a) {
+	if (valid)
+		q[a] = w.sumAt(a, active.data(), (int)active.size());
+}
+
+void TileStepCache::swapOutActive(vector<int> & buffer) {
+	active.swap(buffer);
+	valid = false;
+}
+
+const vector<int> & TileStepCache::getActive() const {
+	return active;
+}
+
+const QValues & TileStepCache::getQ() const {
+	return q;
+}
+
+size_t TileStepCache::getMemory() const {
+	return state.capacity() * sizeof(double) + active.capacity() * sizeof(int);
+}
+
+bool SparseStepCache::load(const FourierBasis & fb, const SparseState & s, const ShiftedWeightMatrix & w) {
+	if (holds(s))
+		return true;
+	state = s;
+	fb.basify(s, phi);
+	for (int a = 0; a < w.getNumRows(); a++)
+		q[a] = w.dot(a, phi);
+	valid = true;
+	return false;
+}
+
+bool SparseStepCache::holds(const SparseState & s) const {
+	return valid && (s == state);
+}
+
+void SparseStepCache::refresh(const ShiftedWeightMatrix & w, const int & a) {
+	if (valid)
+		q[a] = w.dot(a, phi);
+}
+
+void SparseStepCache::swapOutPhi(SparseFeatures & buffer) {
+	phi.swap(buffer);
+	valid = false;
+}
+
+const SparseFeatures & SparseStepCache::getPhi() const {
+	return phi;
+}
+
+const QValues & SparseStepCache::getQ() const {
+	return q;
+}
+
+size_t SparseStepCache::getMemory() const {
+	return state.getMemory() + phi.getMemory();
+}
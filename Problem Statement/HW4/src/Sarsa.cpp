@@ -3,12 +3,14 @@
 using namespace std;
 
 // This is the constructor. If you added member variables, be sure to initialize them here.
-Sarsa::Sarsa(const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & iOrder, const int & dOrder) : stateDim(stateDim), numActions(numActions), alpha(alpha), gamma(gamma) {
-	fb.init(stateDim, iOrder, dOrder);
-	numFeatures = fb.getNumOutputs();
-	w.resize(numActions);
-	for (int a = 0; a < numActions; a++)
-		w[a] = vector<double>(numFeatures, 0.0);
+Sarsa::Sarsa(const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & iOrder, const int & dOrder, const int & coupledTermBudget) : stateDim(stateDim), numActions(numActions), alpha(alpha), gamma(gamma) {
+	if (numActions > maxNumActions)
+		throw invalid_argument("Sarsa supports at most maxNumActions actions");
+	shared_ptr<FourierBasis> basis = make_shared<FourierBasis>();
+	basis->init(stateDim, iOrder, dOrder, coupledTermBudget);
+	fb = basis;
+	numFeatures = fb->getNumOutputs();
+	w.resize(numActions, numFeatures);
 	d1 = bernoulli_distribution(epsilon);
 	d2 = uniform_int_distribution<int>(0, numActions - 1);
 }
@@ -16,29 +18,32 @@ Sarsa::Sarsa(const int & stateDim, const int & numActions, const double & alpha,
 // This is the train function. While the contents will differ from QLearning, you might copy the general structure (if-statements checking that terms are initialized, compute TD-error, update weights, set cur <-- new (curState, curAction, curReward?)
 void Sarsa::train(std::mt19937_64 & generator, const std::vector<double> & s, const int & a, double & r, const std::vector<double> & sPrime, const bool & sPrimeTerminal) {
 	
-	std::vector<double> s_dash = s;
-	std::vector<double> phi_s_dash = fb.basify(s_dash);
+	// phi(s) and q(s,.), usually already computed by getAction(s).
+	loadCache(s);
+	const std::vector<double> & phi_s_dash = cache.getPhi();
 
 	if (flag == true) {
 
-		double term3 = dot(w[previous_a], phi_s);
-		double term2 = gamma * dot(w[a], phi_s_dash);
+		double term3 = w.dot(previous_a, phi_s);
+		double term2 = gamma * cache.getQ()[a];
 		double TDerror = previous_r + term2 - term3;
 
-		for (int i = 0; i < (int)w[previous_a].size(); i++)	w[previous_a][i] += alpha * TDerror * phi_s[i];
+		w.addScaled(previous_a, alpha * TDerror, phi_s);
+		cache.refresh(w, previous_a);
 
 		if (sPrimeTerminal == true) {
-			double term3 = dot(w[a], phi_s_dash);
+			double term3 = cache.getQ()[a];
 			double term2 = gamma * 0.0;
 			double TDerror = r + term2 - term3;
-			for (int i = 0; i < (int)w[a].size(); i++) w[a][i] += alpha * TDerror * phi_s_dash[i];
+			w.addScaled(a, alpha * TDerror, phi_s_dash);
+			cache.refresh(w, a);
 		}
 	}
 
 	flag = true;
 	previous_a = a;
 	previous_r = r;
-	phi_s = phi_s_dash;
+	cache.swapOutPhi(phi_s);	// phi_s = phi_s_dash, without a copy. The cache reuses the old phi_s buffer.
 
 }
 
@@ -51,20 +56,67 @@ void Sarsa::newEpisode(mt19937_64 & generator) {
 int Sarsa::getAction(const std::vector<double> & s, std::mt19937_64 & generator) {
 	if (d1(generator)) // Explore
 		return d2(generator);
-	vector<double> features = fb.basify(s);
-	vector<int> bestActions(1, 0);
-	double bestActionValue = dot(w[0],features);
-	for (int a = 1; a < numActions; a++) {
-		double curActionValue = dot(w[a], features);
-		if (curActionValue == bestActionValue)
-			bestActions.push_back(a);
-		else if (curActionValue > bestActionValue) {
-			bestActionValue = curActionValue;
-			bestActions.resize(1);
-			bestActions[0] = a;
+	loadCache(s);
+	return greedyAction(cache.getQ(), numActions, generator);
+}
+
+// The same as train above, with sparse features and weights.
+void Sarsa::train(std::mt19937_64 & generator, const SparseState & s, const int & a, double & r, const SparseState & sPrime, const bool & sPrimeTerminal) {
+	initSparseWeights();
+	sparseCache.load(*fb, s, sparseW);
+	const SparseFeatures & phi_s_dash = sparseCache.getPhi();
+
+	if (flag == true) {
+		double TDerror = previous_r + gamma * sparseCache.getQ()[a] - sparseW.dot(previous_a, sparse_phi_s);
+		sparseW.addScaled(previous_a, alpha * TDerror, sparse_phi_s);
+		sparseCache.refresh(sparseW, previous_a);
+
+		if (sPrimeTerminal == true) {
+			double TDerror = r - sparseCache.getQ()[a];
+			sparseW.addScaled(a, alpha * TDerror, phi_s_dash);
+			sparseCache.refresh(sparseW, a);
 		}
 	}
-	if ((int)bestActions.size() == 1)
-		return bestActions[0];
-	return (uniform_int_distribution<int>(0, (int)bestActions.size() - 1))(generator);
-}
\ No newline at end of file
+
+	flag = true;
+	previous_a = a;
+	previous_r = r;
+	sparseCache.swapOutPhi(sparse_phi_s);
+}
+
+int Sarsa::getAction(const SparseState & s, std::mt19937_64 & generator) {
+	if (d1(generator))
+		return d2(generator);
+	initSparseWeights();
+	sparseCache.load(*fb, s, sparseW);
+	return greedyAction(sparseCache.getQ(), numActions, generator);
+}
+
+void Sarsa::initSparseWeights() {
+	if (sparseW.getNumRows() == 0)
+		sparseW.assign(w);
+}
+
+size_t Sarsa::getTrialMemory() const {
+	return sizeof(Sarsa) + w.getMemory() + phi_s.capacity() * sizeof(double) + cache.getMemory() + featureCache.getMemory()
+		+ sparseW.getMemory() + sparse_phi_s.getMemory() + sparseCache.getMemory();
+}
+
+size_t Sarsa::getSharedMemory() const {
+	return fb->getMemory();
+}
+
+void Sarsa::enableFeatureCache(const int & capacity, const vector<double> & cellSize) {
+	featureCache.reset(fb, capacity, cellSize);
+}
+
+const FeatureCache & Sarsa::getFeatureCache() const {
+	return featureCache;
+}
+
+void Sarsa::loadCache(const vector<double> & s) {
+	if (featureCache.isEnabled())
+		cache.load(featureCache, s, w);
+	else
+		cache.load(*fb, s, w);
+}
@@ -0,0 +1,75 @@
+#include "stdafx.h"
+
+using namespace std;
+
+ShiftedWeightMatrix::ShiftedWeightMatrix() {}
+
+void ShiftedWeightMatrix::assign(const WeightMatrix & w) {
+	base = w;
+	shift.assign(w.getNumRows(), 0.0);
+	rowSum.assign(w.getNumRows(), 0.0);
+	updatesSinceResum.assign(w.getNumRows(), 0);
+	for (int a = 0; a < w.getNumRows(); a++)
+		resum(a);
+}
+
+void ShiftedWeightMatrix::copyTo(WeightMatrix & w) const {
+	for (int a = 0; a < getNumRows(); a++) {
+		const double * from = base.row(a);
+		double * to = w.row(a);
+		for (int i = 0; i < getNumColumns(); i++)
+			to[i] = from[i] + shift[a];
+	}
+}
+
+int ShiftedWeightMatrix::getNumRows() const {
+	return base.getNumRows();
+}
+
+int ShiftedWeightMatrix::getNumColumns() const {
+	return base.getNumColumns();
+}
+
+double ShiftedWeightMatrix::get(const int & a, const int & i) const {
+	return base.row(a)[i] + shift[a];
+}
+
+double ShiftedWeightMatrix::dot(const int & a, const SparseFeatures & phi) const {
+	const double * wa = base.row(a);
+	const int * terms = phi.getTerms();
+	const double * d = phi.getDeviations();
+	double result = 0;
+	for (int j = 0; j < phi.getNumTerms(); j++)
+		result += (wa[terms[j]] + shift[a]) * d[j];
+	return rowSum[a] + (double)getNumColumns() * shift[a] + result;
+}
+
+void ShiftedWeightMatrix::addScaled(const int & a, const double & scale, const SparseFeatures & phi) {
+	double * wa = base.row(a);
+	const int * terms = phi.getTerms();
+	const double * d = phi.getDeviations();
+	double change = 0;
+	for (int j = 0; j < phi.getNumTerms(); j++) {
+		const double before = wa[terms[j]];
+		wa[terms[j]] += scale * d[j];
+		change += wa[terms[j]] - before;	// What was actually added, after rounding
+	}
+	shift[a] += scale;
+	if (++updatesSinceResum[a] >= getNumColumns())
+		resum(a);
+	else
+		rowSum[a] += change;
+}
+
+size_t ShiftedWeightMatrix::getMemory() const {
+	return base.getMemory() + (shift.capacity() + rowSum.capacity()) * sizeof(double) + updatesSinceResum.capacity() * sizeof(int);
+}
+
+void ShiftedWeightMatrix::resum(const int & a) {
+	const double * wa = base.row(a);
+	double result = 0;
+	for (int i = 0; i < getNumColumns(); i++)
+		result += wa[i];
+	rowSum[a] = result;
+	updatesSinceResum[a] = 0;
+}
@@ -0,0 +1,132 @@
+#include "stdafx.h"
+
+using namespace std;
+
+SparseState::SparseState() : dimension(0) {}
+
+SparseState::SparseState(const int & dimension) : dimension(dimension) {}
+
+void SparseState::reset(const int & dimension) {
+	this->dimension = dimension;
+	indices.clear();
+	values.clear();
+}
+
+void SparseState::setOneHot(const int & dimension, const int & index) {
+	reset(dimension);
+	push(index, 1.0);
+}
+
+void SparseState::push(const int & index, const double & value) {
+	assert((index >= 0) && (index < dimension) && (indices.empty() || (indices.back() < index)));
+	indices.push_back(index);
+	values.push_back(value);
+}
+
+int SparseState::getDimension() const {
+	return dimension;
+}
+
+int SparseState::getNumNonzeros() const {
+	return (int)indices.size();
+}
+
+const int * SparseState::getIndices() const {
+	return indices.data();
+}
+
+const double * SparseState::getValues() const {
+	return values.data();
+}
+
+void SparseState::toDense(vector<double> & result) const {
+	result.assign(dimension, 0.0);
+	for (size_t e = 0; e < indices.size(); e++)
+		result[indices[e]] = values[e];
+}
+
+vector<double> SparseState::toDense() const {
+	vector<double> result;
+	toDense(result);
+	return result;
+}
+
+bool SparseState::operator==(const SparseState & other) const {
+	return (dimension == other.dimension) && (indices == other.indices) && (values == other.values);
+}
+
+bool SparseState::operator!=(const SparseState & other) const {
+	return !(*this == other);
+}
+
+void SparseState::swap(SparseState & other) {
+	std::swap(dimension, other.dimension);
+	indices.swap(other.indices);
+	values.swap(other.values);
+}
+
+size_t SparseState::getMemory() const {
+	return indices.capacity() * sizeof(int) + values.capacity() * sizeof(double);
+}
+
+int SparseFeatures::getNumTerms() const {
+	return (int)terms.size();
+}
+
+const int * SparseFeatures::getTerms() const {
+	return terms.data();
+}
+
+const double * SparseFeatures::getDeviations() const {
+	return deviations.data();
+}
+
+void SparseFeatures::beginArguments(const int & numOutputs) {
+	terms.clear();
+	deviations.clear();
+	if ((int)slot.size() < numOutputs)
+		slot.resize(numOutputs, -1);
+}
+
+void SparseFeatures::addArgument(const int & term, const double & value) {
+	if (slot[term] < 0) {
+		slot[term] = (int)terms.size();
+		terms.push_back(term);
+		deviations.push_back(0.0);
+	}
+	deviations[slot[term]] += value;
+}
+
+void SparseFeatures::endArguments(const CosineMode & mode) {
+	const int n = (int)terms.size();
+	cosPi(deviations.data(), deviations.data(), n, mode);
+	for (int j = 0; j < n; j++) {
+		deviations[j] -= 1.0;
+		slot[terms[j]] = -1;
+	}
+}
+
+double * SparseFeatures::beginAllArguments(const int & numOutputs) {
+	beginArguments(numOutputs);		// For slot, which endArguments resets
+	terms.resize(numOutputs);
+	for (int i = 0; i < numOutputs; i++)
+		terms[i] = i;
+	deviations.resize(numOutputs);
+	return deviations.data();
+}
+
+const double * SparseFeatures::denseInput(const SparseState & x) {
+	x.toDense(input);
+	return input.data();
+}
+
+void SparseFeatures::swap(SparseFeatures & other) {
+	terms.swap(other.terms);
+	deviations.swap(other.deviations);
+	slot.swap(other.slot);
+	input.swap(other.input);
+}
+
+size_t SparseFeatures::getMemory() const {
+	return (terms.capacity() + slot.capacity()) * sizeof(int) + (deviations.capacity() + input.capacity()) * sizeof(double);
+}
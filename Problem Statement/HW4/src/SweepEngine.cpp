@@ -0,0 +1,56 @@
+#include "stdafx.h"
+
+using namespace std;
+
+SweepEngine::SweepEngine(ThreadPool & pool, const bool & verbose) : pool(pool), verbose(verbose), running(false) {}
+
+SweepEngine::~SweepEngine() {
+	pool.wait();
+}
+
+void SweepEngine::wait() {
+	pool.wait();
+	if (!running)
+		return;
+	running = false;
+	if (!verbose)
+		return;
+	const double wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	const vector<double> busySeconds = pool.getBusySeconds();
+	const int numThreads = (int)busySeconds.size();
+	double busy = 0;
+	for (int w = 0; w < numThreads; w++)
+		busy += busySeconds[w] - busyAtStart[w];
+	const double overall = (wallSeconds > 0) ? 100.0 * busy / (wallSeconds * numThreads) : 100.0;
+	cout << "Thread utilization: " << overall << "% of " << numThreads << " threads over " << wallSeconds << " s (";
+	for (int w = 0; w < numThreads; w++) {
+		const double utilization = (wallSeconds > 0) ? 100.0 * (busySeconds[w] - busyAtStart[w]) / wallSeconds : 100.0;
+		cout << (w ? ", " : "") << "thread " << w << ": " << utilization << "%";
+	}
+	cout << ")" << endl;
+}
+
+void SweepEngine::finishTrial(Experiment & experiment) {
+	if (--experiment.remaining > 0)
+		return;
+	// The last trial: the statistics of runExperiment.
+	const int numTrials = (int)experiment.returns.size(), numEpisodes = numTrials ? (int)experiment.returns[0].size() : 0;
+	vector<double> means(numEpisodes, 0.0), vars(numEpisodes, 0.0), cur(numTrials);
+	for (int epCount = 0; epCount < numEpisodes; epCount++) {
+		for (int trial = 0; trial < numTrials; trial++)
+			cur[trial] = experiment.returns[trial][epCount];
+		means[epCount] = mean(cur);
+		vars[epCount] = var(cur);
+	}
+	experiment.returns.clear();
+	lock_guard<mutex> guard(handlerLock);
+	experiment.onDone(means, vars);
+}
+
+void SweepEngine::begin() {
+	if (running)
+		return;
+	running = true;
+	start = chrono::steady_clock::now();
+	busyAtStart = pool.getBusySeconds();
+}
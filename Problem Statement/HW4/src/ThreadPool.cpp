@@ -0,0 +1,78 @@
+#include "stdafx.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+ThreadPool::ThreadPool(const int & numThreads) : numRunning(0), stopping(false) {
+	int n = numThreads;
+	if (n <= 0) {
+#ifdef _OPENMP
+		n = omp_get_max_threads();
+#else
+		n = (int)thread::hardware_concurrency();
+#endif
+	}
+	n = max(n, 1);
+	busySeconds.assign(n, 0.0);
+	for (int w = 0; w < n; w++)
+		workers.emplace_back(&ThreadPool::work, this, w);
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		lock_guard<mutex> guard(lock);
+		stopping = true;
+	}
+	taskReady.notify_all();
+	for (thread & worker : workers)
+		worker.join();
+}
+
+ThreadPool & ThreadPool::shared() {
+	static ThreadPool pool;
+	return pool;
+}
+
+int ThreadPool::getNumThreads() const {
+	return (int)workers.size();
+}
+
+void ThreadPool::submit(function<void()> task) {
+	{
+		lock_guard<mutex> guard(lock);
+		tasks.push_back(move(task));
+	}
+	taskReady.notify_one();
+}
+
+void ThreadPool::wait() {
+	unique_lock<mutex> guard(lock);
+	idle.wait(guard, [&] { return tasks.empty() && (numRunning == 0); });
+}
+
+vector<double> ThreadPool::getBusySeconds() const {
+	lock_guard<mutex> guard(lock);
+	return busySeconds;
+}
+
+void ThreadPool::work(const int & worker) {
+	unique_lock<mutex> guard(lock);
+	for (;;) {
+		taskReady.wait(guard, [&] { return stopping || !tasks.empty(); });
+		if (tasks.empty())		// Stopping, with nothing left to run
+			return;
+		function<void()> task = move(tasks.front());
+		tasks.pop_front();
+		numRunning++;
+		guard.unlock();
+		const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		task();
+		const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		guard.lock();
+		busySeconds[worker] += seconds;
+		if ((--numRunning == 0) && tasks.empty())
+			idle.notify_all();
+	}
+}
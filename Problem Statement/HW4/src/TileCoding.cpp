@@ -0,0 +1,59 @@
+#include "stdafx.h"
+
+using namespace std;
+
+void TileCoding::init(const int & inputDimension, const int & numTilings, const int & tilesPerDimension) {
+	if ((numTilings < 1) || (tilesPerDimension < 1))
+		throw invalid_argument("TileCoding: numTilings and tilesPerDimension must be positive");
+	this->inputDimension = inputDimension;
+	this->numTilings = numTilings;
+	this->tilesPerDimension = tilesPerDimension;
+	long long size = 1;
+	placeValue.resize(inputDimension);
+	for (int k = 0; k < inputDimension; k++) {
+		placeValue[k] = (int)size;
+		size *= tilesPerDimension + 1;
+		if (size * numTilings > INT_MAX)
+			throw overflow_error("TileCoding: too many tiles (use fewer tilings or tiles per dimension)");
+	}
+	tilesPerTiling = (int)size;
+	// Shift tiling t by t/numTilings of a tile times the odd numbers 1, 3, 5, ... along the successive inputs (wrapped into [0,1)),
+	// so that the tilings are not all displaced along the diagonal.
+	offset.resize((size_t)numTilings * inputDimension);
+	for (int t = 0; t < numTilings; t++)
+		for (int k = 0; k < inputDimension; k++)
+			offset[(size_t)t * inputDimension + k] = (double)((t * (2 * k + 1)) % numTilings) / numTilings;
+}
+
+int TileCoding::getNumOutputs() const {
+	return numTilings * tilesPerTiling;
+}
+
+int TileCoding::getNumActive() const {
+	return numTilings;
+}
+
+int TileCoding::getInputDimension() const {
+	return inputDimension;
+}
+
+void TileCoding::basify(const double * x, int * active) const {
+	for (int t = 0; t < numTilings; t++) {
+		const double * shift = &offset[(size_t)t * inputDimension];
+		int index = t * tilesPerTiling;
+		for (int k = 0; k < inputDimension; k++) {
+			const double xk = min(1.0, max(0.0, x[k]));
+			index += (int)(xk * tilesPerDimension + shift[k]) * placeValue[k];	// The tile coordinate is at most tilesPerDimension
+		}
+		active[t] = index;
+	}
+}
+
+void TileCoding::basify(const vector<double> & x, vector<int> & active) const {
+	active.resize(numTilings);
+	basify(x.data(), active.data());
+}
+
+size_t TileCoding::getMemory() const {
+	return sizeof(TileCoding) + offset.capacity() * sizeof(double) + placeValue.capacity() * sizeof(int);
+}
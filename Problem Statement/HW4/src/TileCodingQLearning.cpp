@@ -0,0 +1,52 @@
+#include "stdafx.h"
+
+using namespace std;
+
+TileCodingQLearning::TileCodingQLearning(const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & numTilings, const int & tilesPerDimension) : numActions(numActions), numTilings(numTilings), alpha(alpha), gamma(gamma) {
+	if (numActions > maxNumActions)
+		throw invalid_argument("TileCodingQLearning supports at most maxNumActions actions");
+	shared_ptr<TileCoding> tiling = make_shared<TileCoding>();
+	tiling->init(stateDim, numTilings, tilesPerDimension);
+	tc = tiling;
+	w.resize(numActions, tc->getNumOutputs());
+	active.assign(numTilings, 0);
+	d1 = bernoulli_distribution(epsilon);
+	d2 = uniform_int_distribution<int>(0, numActions - 1);
+}
+
+void TileCodingQLearning::train(mt19937_64 & generator, const vector<double> & s, const int & a, double & r, const vector<double> & sPrime, const bool & sPrimeTerminal) {
+	// The active tiles of s, usually cached as those of sPrime at the previous step (see QLearning::train)
+	if (cache.holds(s))
+		cache.swapOutActive(active);
+	else
+		tc->basify(s, active);
+
+	double TDerror;
+	if (sPrimeTerminal)
+		TDerror = r - w.sumAt(a, active.data(), numTilings);
+	else {
+		cache.load(*tc, sPrime, w);
+		TDerror = r + gamma * maxQValue(cache.getQ(), numActions) - w.sumAt(a, active.data(), numTilings);
+	}
+
+	w.addAt(a, alpha * TDerror, active.data(), numTilings);	// w[a] += alpha*TDerror*phi(s), on the active tiles only
+	cache.refresh(w, a);
+}
+
+void TileCodingQLearning::newEpisode(mt19937_64 & generator) {
+}
+
+int TileCodingQLearning::getAction(const vector<double> & s, mt19937_64 & generator) {
+	if (d1(generator))
+		return d2(generator);
+	cache.load(*tc, s, w);
+	return greedyAction(cache.getQ(), numActions, generator);
+}
+
+size_t TileCodingQLearning::getTrialMemory() const {
+	return sizeof(TileCodingQLearning) + w.getMemory() + active.capacity() * sizeof(int) + cache.getMemory();
+}
+
+size_t TileCodingQLearning::getSharedMemory() const {
+	return tc->getMemory();
+}
@@ -0,0 +1,58 @@
+#include "stdafx.h"
+
+using namespace std;
+
+TileCodingSarsa::TileCodingSarsa(const int & stateDim, const int & numActions, const double & alpha, const double & gamma, const double & epsilon, const int & numTilings, const int & tilesPerDimension) : numActions(numActions), numTilings(numTilings), alpha(alpha), gamma(gamma) {
+	if (numActions > maxNumActions)
+		throw invalid_argument("TileCodingSarsa supports at most maxNumActions actions");
+	shared_ptr<TileCoding> tiling = make_shared<TileCoding>();
+	tiling->init(stateDim, numTilings, tilesPerDimension);
+	tc = tiling;
+	w.resize(numActions, tc->getNumOutputs());
+	d1 = bernoulli_distribution(epsilon);
+	d2 = uniform_int_distribution<int>(0, numActions - 1);
+}
+
+void TileCodingSarsa::train(mt19937_64 & generator, const vector<double> & s, const int & a, double & r, const vector<double> & sPrime, const bool & sPrimeTerminal) {
+	cache.load(*tc, s, w);
+	const vector<int> & active_s_dash = cache.getActive();
+
+	if (flag == true) {
+		double term3 = w.sumAt(previous_a, active_s.data(), numTilings);
+		double term2 = gamma * cache.getQ()[a];
+		double TDerror = previous_r + term2 - term3;
+		w.addAt(previous_a, alpha * TDerror, active_s.data(), numTilings);
+		cache.refresh(w, previous_a);
+
+		if (sPrimeTerminal == true) {
+			double term3 = cache.getQ()[a];
+			double TDerror = r - term3;
+			w.addAt(a, alpha * TDerror, active_s_dash.data(), numTilings);
+			cache.refresh(w, a);
+		}
+	}
+
+	flag = true;
+	previous_a = a;
+	previous_r = r;
+	cache.swapOutActive(active_s);	// active_s = active_s_dash, without a copy
+}
+
+void TileCodingSarsa::newEpisode(mt19937_64 & generator) {
+	flag = false;
+}
+
+int TileCodingSarsa::getAction(const vector<double> & s, mt19937_64 & generator) {
+	if (d1(generator))
+		return d2(generator);
+	cache.load(*tc, s, w);
+	return greedyAction(cache.getQ(), numActions, generator);
+}
+
+size_t TileCodingSarsa::getTrialMemory() const {
+	return sizeof(TileCodingSarsa) + w.getMemory() + active_s.capacity() * sizeof(int) + cache.getMemory();
+}
+
+size_t TileCodingSarsa::getSharedMemory() const {
+	return tc->getMemory();
+}
@@ -0,0 +1,176 @@
+#include "stdafx.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+// Definition of the static constant, which std::min takes by reference
+const int TrialScheduler::defaultChunksPerTrial;
+
+TrialScheduler::TrialScheduler(const int & numTrials, const int & numChunks, const vector<double> & expectedSeconds) : numTrials(numTrials), numChunks(numChunks), wallSeconds(0) {
+	// Trials without a history (expectedSeconds is shorter, e.g. numTrials grew) are expected to take the mean of the others.
+	double sum = 0;
+	for (double seconds : expectedSeconds)
+		sum += seconds;
+	const double fallback = expectedSeconds.empty() ? -1.0 : sum / expectedSeconds.size();
+	expected.assign(numTrials, fallback);
+	for (int t = 0; t < min(numTrials, (int)expectedSeconds.size()); t++)
+		expected[t] = expectedSeconds[t];
+	trialSeconds.assign(numTrials, 0.0);
+}
+
+void TrialScheduler::run(const function<void(int, int)> & task) {
+#ifdef _OPENMP
+	const int numThreads = max(1, min(omp_get_max_threads(), numTrials));
+#else
+	const int numThreads = 1;
+#endif
+	trialSeconds.assign(numTrials, 0.0);
+	nextChunk.assign(numTrials, 0);
+	queues.assign(numThreads, vector<int>());
+	locks.reset(new mutex[numThreads]);
+	chunkSecondsSum = 0;
+	numChunksRun = 0;
+	meanChunkSeconds = 0.0;
+	numUnfinished = (numChunks > 0) ? numTrials : 0;
+	numQueued = numUnfinished.load();
+	busySeconds.assign(numThreads, 0.0);
+	chunksRun.assign(numThreads, 0);
+	steals.assign(numThreads, 0);
+	// Deal the trials out longest first, so every thread starts with one of the longest trials that are left.
+	vector<int> order(numTrials);
+	for (int t = 0; t < numTrials; t++)
+		order[t] = t;
+	stable_sort(order.begin(), order.end(), [&](const int & a, const int & b) { return expected[a] > expected[b]; });
+	for (int n = 0; (n < numTrials) && (numChunks > 0); n++)
+		queues[n % numThreads].push_back(order[n]);
+
+	const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	#pragma omp parallel num_threads(numThreads)
+	{
+#ifdef _OPENMP
+		const int q = omp_get_thread_num();
+#else
+		const int q = 0;
+#endif
+		while (numUnfinished > 0) {
+			const int trial = take(q);
+			if (trial < 0) {		// Every other trial is running: sleep until one comes back between two chunks, or all have finished
+				unique_lock<mutex> guard(waitLock);
+				workQueued.wait(guard, [&] { return (numUnfinished == 0) || (numQueued > 0); });
+				continue;
+			}
+			const chrono::steady_clock::time_point chunkStart = chrono::steady_clock::now();
+			task(trial, nextChunk[trial]);
+			const double seconds = chrono::duration<double>(chrono::steady_clock::now() - chunkStart).count();
+			trialSeconds[trial] += seconds;
+			busySeconds[q] += seconds;
+			chunksRun[q]++;
+			{
+				lock_guard<mutex> guard(statsLock);
+				chunkSecondsSum += seconds;
+				numChunksRun++;
+				meanChunkSeconds = chunkSecondsSum / numChunksRun;
+			}
+			if (++nextChunk[trial] < numChunks) {
+				{
+					lock_guard<mutex> guard(locks[q]);
+					queues[q].push_back(trial);
+				}
+				numQueued++;
+				wake(false);
+			}
+			else if (--numUnfinished == 0)
+				wake(true);
+		}
+	}
+	wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+const vector<double> & TrialScheduler::getTrialSeconds() const {
+	return trialSeconds;
+}
+
+void TrialScheduler::reportUtilization() const {
+	double busy = 0;
+	for (double seconds : busySeconds)
+		busy += seconds;
+	const int numThreads = (int)busySeconds.size();
+	const double overall = (wallSeconds > 0) ? 100.0 * busy / (wallSeconds * numThreads) : 100.0;
+	cout << "Thread utilization: " << overall << "% of " << numThreads << " threads over " << wallSeconds << " s (";
+	for (int q = 0; q < numThreads; q++) {
+		const double utilization = (wallSeconds > 0) ? 100.0 * busySeconds[q] / wallSeconds : 100.0;
+		cout << (q ? ", " : "") << "thread " << q << ": " << utilization << "%, " << chunksRun[q] << " chunks, " << steals[q] << " stolen";
+	}
+	cout << ")" << endl;
+}
+
+int TrialScheduler::popLongest(const int & q) {
+	vector<int> & queue = queues[q];
+	if (queue.empty())
+		return -1;
+	size_t best = 0;
+	double bestRemaining = expectedRemaining(queue[0]);
+	for (size_t i = 1; i < queue.size(); i++) {
+		const double remaining = expectedRemaining(queue[i]);
+		if (remaining > bestRemaining) {
+			best = i;
+			bestRemaining = remaining;
+		}
+	}
+	const int trial = queue[best];
+	queue.erase(queue.begin() + best);
+	numQueued--;	// Keep the order, so that ties go to the trial that has waited longest
+	return trial;
+}
+
+int TrialScheduler::take(const int & q) {
+	{
+		lock_guard<mutex> guard(locks[q]);
+		const int trial = popLongest(q);
+		if (trial >= 0)
+			return trial;
+	}
+	// Steal from the queue whose longest trial is expected to take the longest.
+	const int numThreads = (int)queues.size();
+	int victim = -1;
+	double victimRemaining = -1;
+	for (int n = 1; n < numThreads; n++) {
+		const int v = (q + n) % numThreads;
+		lock_guard<mutex> guard(locks[v]);
+		for (int trial : queues[v]) {
+			const double remaining = expectedRemaining(trial);
+			if (remaining > victimRemaining) {
+				victim = v;
+				victimRemaining = remaining;
+			}
+		}
+	}
+	if (victim < 0)
+		return -1;
+	lock_guard<mutex> guard(locks[victim]);
+	const int trial = popLongest(victim);	// The queue may have changed since the scan: take whatever is longest now
+	if (trial >= 0)
+		steals[q]++;
+	return trial;
+}
+
+void TrialScheduler::wake(const bool & all) {
+	{
+		lock_guard<mutex> guard(waitLock);	// A thread between its check and its wait holds waitLock, so it cannot miss the signal
+	}
+	if (all)
+		workQueued.notify_all();
+	else
+		workQueued.notify_one();
+}
+
+double TrialScheduler::expectedRemaining(const int & trial) const {
+	const int done = nextChunk[trial];
+	if (done > 0)
+		return trialSeconds[trial] / done * (numChunks - done);
+	if (expected[trial] >= 0)
+		return expected[trial];
+	return meanChunkSeconds * numChunks;
+}
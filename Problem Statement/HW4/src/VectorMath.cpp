@@ -0,0 +1,275 @@
+#include "stdafx.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define VECTORMATH_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and clang only emit AVX instructions inside functions compiled for that target. MSVC emits them anywhere, so the macros
+// are empty there. fp-contract=off stops the compiler from fusing a multiply and an add into an FMA (AVX-512 always has FMA),
+// which would change the last bit of the results and make the levels disagree.
+#if defined(__GNUC__)
+#define TARGET_SCALAR __attribute__((optimize("fp-contract=off")))
+#define TARGET_AVX2 __attribute__((target("avx2"), optimize("fp-contract=off")))
+#define TARGET_AVX512 __attribute__((target("avx512f"), optimize("fp-contract=off")))
+#else
+#define TARGET_SCALAR
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif
+
+using namespace std;
+
+// Taylor coefficients of sin(pi*s)/s in powers of s^2: (-1)^k pi^(2k+1) / (2k+1)!, k = 0..10. For |s| <= 1/2 the first omitted
+// term is below 2e-18, so the truncation error is well under an ulp of the result.
+static const int numSinPiCoefficients = 11;
+static const double sinPiCoefficients[numSinPiCoefficients] = {
+	3.14159265358979323846,
+	-5.16771278004997002925,
+	2.55016403987734544386,
+	-0.599264529320792076888,
+	0.0821458866111282287988,
+	-0.00737043094571435077726,
+	0.000466302805767612564421,
+	-0.0000219153534478302158274,
+	7.95205400147551278478e-7,
+	-2.29484289972698731102e-8,
+	5.39266466260812848935e-10
+};
+
+static SimdLevel detectSimdLevel() {
+#if defined(VECTORMATH_X86) && defined(__GNUC__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+		return SimdLevel::AVX512;
+	if (__builtin_cpu_supports("avx2"))
+		return SimdLevel::AVX2;
+#elif defined(VECTORMATH_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] >= 7) {
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+		if (osxsave && avx) {
+			unsigned long long xcr0 = _xgetbv(0);
+			__cpuidex(info, 7, 0);
+			if (((xcr0 & 0xE6) == 0xE6) && (info[1] & (1 << 16)))	// OS saves the ZMM registers, and AVX-512F
+				return SimdLevel::AVX512;
+			if (((xcr0 & 0x6) == 0x6) && (info[1] & (1 << 5)))		// OS saves the YMM registers, and AVX2
+				return SimdLevel::AVX2;
+		}
+	}
+#endif
+	return SimdLevel::Scalar;
+}
+
+SimdLevel getSimdLevel() {
+	static const SimdLevel level = detectSimdLevel();
+	return level;
+}
+
+const char * simdLevelName(const SimdLevel & level) {
+	if (level == SimdLevel::AVX512)
+		return "AVX-512";
+	if (level == SimdLevel::AVX2)
+		return "AVX2";
+	return "scalar";
+}
+
+// Fast cos(pi*t) for one element. The vector versions below perform exactly the same operations, lane by lane.
+TARGET_SCALAR static double cosPiFastScalar(const double & t) {
+	double r = t - 2.0 * nearbyint(0.5 * t);	// Exact: r in [-1,1], and cos(pi*t) = cos(pi*r)
+	double s = 0.5 - fabs(r);					// cos(pi*|r|) = sin(pi*s), with s in [-1/2,1/2]
+	double s2 = s * s, p = sinPiCoefficients[numSinPiCoefficients - 1];
+	for (int k = numSinPiCoefficients - 2; k >= 0; k--)
+		p = p * s2 + sinPiCoefficients[k];
+	return s * p;
+}
+
+TARGET_SCALAR static void cosPiFastScalar(const double * t, double * out, const int & n) {
+	for (int i = 0; i < n; i++)
+		out[i] = cosPiFastScalar(t[i]);
+}
+
+#ifdef VECTORMATH_X86
+TARGET_AVX2 static void cosPiFastAVX2(const double * t, double * out, const int & n) {
+	const __m256d half = _mm256_set1_pd(0.5), two = _mm256_set1_pd(2.0), signMask = _mm256_set1_pd(-0.0);
+	int i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m256d x = _mm256_loadu_pd(t + i);
+		__m256d k = _mm256_round_pd(_mm256_mul_pd(half, x), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		__m256d r = _mm256_sub_pd(x, _mm256_mul_pd(two, k));
+		__m256d s = _mm256_sub_pd(half, _mm256_andnot_pd(signMask, r));
+		__m256d s2 = _mm256_mul_pd(s, s), p = _mm256_set1_pd(sinPiCoefficients[numSinPiCoefficients - 1]);
+		for (int j = numSinPiCoefficients - 2; j >= 0; j--)
+			p = _mm256_add_pd(_mm256_mul_pd(p, s2), _mm256_set1_pd(sinPiCoefficients[j]));
+		_mm256_storeu_pd(out + i, _mm256_mul_pd(s, p));
+	}
+	cosPiFastScalar(t + i, out + i, n - i);
+}
+
+TARGET_AVX512 static void cosPiFastAVX512(const double * t, double * out, const int & n) {
+	const __m512d half = _mm512_set1_pd(0.5), two = _mm512_set1_pd(2.0);
+	int i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m512d x = _mm512_loadu_pd(t + i);
+		__m512d halfX = _mm512_mul_pd(half, x);
+		__m512d k = _mm512_mask_roundscale_pd(halfX, (__mmask8)0xFF, halfX, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);	// The unmasked form trips a GCC 12 -Wmaybe-uninitialized bug
+		__m512d r = _mm512_sub_pd(x, _mm512_mul_pd(two, k));
+		__m512d s = _mm512_sub_pd(half, _mm512_abs_pd(r));
+		__m512d s2 = _mm512_mul_pd(s, s), p = _mm512_set1_pd(sinPiCoefficients[numSinPiCoefficients - 1]);
+		for (int j = numSinPiCoefficients - 2; j >= 0; j--)
+			p = _mm512_add_pd(_mm512_mul_pd(p, s2), _mm512_set1_pd(sinPiCoefficients[j]));
+		_mm512_storeu_pd(out + i, _mm512_mul_pd(s, p));
+	}
+	cosPiFastScalar(t + i, out + i, n - i);
+}
+#endif
+
+void cosPi(const double * t, double * out, const int & n, const CosineMode & mode) {
+	cosPi(t, out, n, mode, getSimdLevel());
+}
+
+void cosPi(const double * t, double * out, const int & n, const CosineMode & mode, SimdLevel level) {
+	if (mode == CosineMode::Exact) {
+		for (int i = 0; i < n; i++)
+			out[i] = cos(M_PI*t[i]);
+		return;
+	}
+	level = min(level, getSimdLevel());
+#ifdef VECTORMATH_X86
+	if (level == SimdLevel::AVX512)
+		return cosPiFastAVX512(t, out, n);
+	if (level == SimdLevel::AVX2)
+		return cosPiFastAVX2(t, out, n);
+#endif
+	cosPiFastScalar(t, out, n);
+}
+
+TARGET_SCALAR static void accumulateDotScalar(const double * x, const double * y, const int & n, double * partial) {
+	for (int i = 0; i < n; i++)
+		partial[i % numDotLanes] += x[i] * y[i];
+}
+
+TARGET_SCALAR static void addScaledScalar(const double & scale, const double * x, double * y, const int & n) {
+	for (int i = 0; i < n; i++)
+		y[i] += scale * x[i];
+}
+
+#ifdef VECTORMATH_X86
+// Partial sums 0-3 are kept in acc0 and 4-7 in acc1, so each lane sees the same additions as in the scalar version.
+TARGET_AVX2 static void accumulateDotAVX2(const double * x, const double * y, const int & n, double * partial) {
+	__m256d acc0 = _mm256_loadu_pd(partial), acc1 = _mm256_loadu_pd(partial + 4);
+	int i = 0;
+	for (; i + numDotLanes <= n; i += numDotLanes) {
+		acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+		acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4)));
+	}
+	_mm256_storeu_pd(partial, acc0);
+	_mm256_storeu_pd(partial + 4, acc1);
+	accumulateDotScalar(x + i, y + i, n - i, partial);
+}
+
+TARGET_AVX2 static void addScaledAVX2(const double & scale, const double * x, double * y, const int & n) {
+	const __m256d s = _mm256_set1_pd(scale);
+	int i = 0;
+	for (; i + 4 <= n; i += 4)
+		_mm256_storeu_pd(y + i, _mm256_add_pd(_mm256_loadu_pd(y + i), _mm256_mul_pd(s, _mm256_loadu_pd(x + i))));
+	addScaledScalar(scale, x + i, y + i, n - i);
+}
+
+TARGET_AVX512 static void accumulateDotAVX512(const double * x, const double * y, const int & n, double * partial) {
+	__m512d acc = _mm512_loadu_pd(partial);
+	int i = 0;
+	for (; i + numDotLanes <= n; i += numDotLanes)
+		acc = _mm512_add_pd(acc, _mm512_mul_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+	_mm512_storeu_pd(partial, acc);
+	accumulateDotScalar(x + i, y + i, n - i, partial);
+}
+
+// dotProduct without going through memory for the partial sums (storing them one at a time and then loading them as a vector
+// stalls store forwarding, which dominates for short vectors). The tail is read with a masked load: the masked-off lanes add
+// 0*0 = +0 to their partial sums, which leaves them unchanged, so the result is the same as accumulateDot's.
+TARGET_AVX2 static double dotProductAVX2(const double * x, const double * y, const int & n) {
+	__m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+	int i = 0;
+	for (; i + numDotLanes <= n; i += numDotLanes) {
+		acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+		acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4)));
+	}
+	if (i < n) {
+		const __m256i rest = _mm256_set1_epi64x(n - i);
+		const __m256i mask0 = _mm256_cmpgt_epi64(rest, _mm256_setr_epi64x(0, 1, 2, 3)), mask1 = _mm256_cmpgt_epi64(rest, _mm256_setr_epi64x(4, 5, 6, 7));
+		acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_maskload_pd(x + i, mask0), _mm256_maskload_pd(y + i, mask0)));
+		acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_maskload_pd(x + i + 4, mask1), _mm256_maskload_pd(y + i + 4, mask1)));
+	}
+	double partial[numDotLanes];
+	_mm256_storeu_pd(partial, acc0);
+	_mm256_storeu_pd(partial + 4, acc1);
+	return sumDotLanes(partial);
+}
+
+TARGET_AVX512 static double dotProductAVX512(const double * x, const double * y, const int & n) {
+	__m512d acc = _mm512_setzero_pd();
+	int i = 0;
+	for (; i + numDotLanes <= n; i += numDotLanes)
+		acc = _mm512_add_pd(acc, _mm512_mul_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+	if (i < n) {
+		const __mmask8 mask = (__mmask8)((1u << (n - i)) - 1);
+		acc = _mm512_add_pd(acc, _mm512_mul_pd(_mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i)));
+	}
+	double partial[numDotLanes];
+	_mm512_storeu_pd(partial, acc);
+	return sumDotLanes(partial);
+}
+
+TARGET_AVX512 static void addScaledAVX512(const double & scale, const double * x, double * y, const int & n) {
+	const __m512d s = _mm512_set1_pd(scale);
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+		_mm512_storeu_pd(y + i, _mm512_add_pd(_mm512_loadu_pd(y + i), _mm512_mul_pd(s, _mm512_loadu_pd(x + i))));
+	addScaledScalar(scale, x + i, y + i, n - i);
+}
+#endif
+
+void accumulateDot(const double * x, const double * y, const int & n, double * partial) {
+#ifdef VECTORMATH_X86
+	const SimdLevel level = getSimdLevel();
+	if (level == SimdLevel::AVX512)
+		return accumulateDotAVX512(x, y, n, partial);
+	if (level == SimdLevel::AVX2)
+		return accumulateDotAVX2(x, y, n, partial);
+#endif
+	accumulateDotScalar(x, y, n, partial);
+}
+
+double sumDotLanes(const double * partial) {
+	return ((partial[0] + partial[1]) + (partial[2] + partial[3])) + ((partial[4] + partial[5]) + (partial[6] + partial[7]));
+}
+
+double dotProduct(const double * x, const double * y, const int & n) {
+#ifdef VECTORMATH_X86
+	const SimdLevel level = getSimdLevel();
+	if (level == SimdLevel::AVX512)
+		return dotProductAVX512(x, y, n);
+	if (level == SimdLevel::AVX2)
+		return dotProductAVX2(x, y, n);
+#endif
+	double partial[numDotLanes] = { 0 };
+	accumulateDotScalar(x, y, n, partial);
+	return sumDotLanes(partial);
+}
+
+void addScaled(const double & scale, const double * x, double * y, const int & n) {
+#ifdef VECTORMATH_X86
+	const SimdLevel level = getSimdLevel();
+	if (level == SimdLevel::AVX512)
+		return addScaledAVX512(scale, x, y, n);
+	if (level == SimdLevel::AVX2)
+		return addScaledAVX2(scale, x, y, n);
+#endif
+	addScaledScalar(scale, x, y, n);
+}
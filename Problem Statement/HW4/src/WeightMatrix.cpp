@@ -0,0 +1,63 @@
+#include "stdafx.h"
+
+using namespace std;
+
+WeightMatrix::WeightMatrix() : numRows(0), numColumns(0), stride(0) {}
+
+WeightMatrix::WeightMatrix(const int & numRows, const int & numColumns) {
+	resize(numRows, numColumns);
+}
+
+void WeightMatrix::resize(const int & numRows, const int & numColumns) {
+	const int lineDoubles = (int)(simdAlignment / sizeof(double));
+	this->numRows = numRows;
+	this->numColumns = numColumns;
+	stride = ((numColumns + lineDoubles - 1) / lineDoubles) * lineDoubles;
+	data.assign((size_t)stride * numRows, 0.0);
+}
+
+int WeightMatrix::getNumRows() const {
+	return numRows;
+}
+
+int WeightMatrix::getNumColumns() const {
+	return numColumns;
+}
+
+int WeightMatrix::getStride() const {
+	return stride;
+}
+
+size_t WeightMatrix::getMemory() const {
+	return data.capacity() * sizeof(double);
+}
+
+double * WeightMatrix::row(const int & a) {
+	return data.data() + (size_t)a * stride;
+}
+
+const double * WeightMatrix::row(const int & a) const {
+	return data.data() + (size_t)a * stride;
+}
+
+double WeightMatrix::dot(const int & a, const vector<double> & phi) const {
+	return dotProduct(row(a), phi.data(), numColumns);
+}
+
+void WeightMatrix::addScaled(const int & a, const double & scale, const vector<double> & phi) {
+	::addScaled(scale, phi.data(), row(a), numColumns);
+}
+
+double WeightMatrix::sumAt(const int & a, const int * active, const int & count) const {
+	const double * wa = row(a);
+	double result = 0;
+	for (int j = 0; j < count; j++)
+		result += wa[active[j]];
+	return result;
+}
+
+void WeightMatrix::addAt(const int & a, const double & value, const int * active, const int & count) {
+	double * wa = row(a);
+	for (int j = 0; j < count; j++)
+		wa[active[j]] += value;
+}
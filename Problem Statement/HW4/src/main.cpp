@@ -5,6 +5,15 @@
 // This let's us not have to write std::vector all the time.
 using namespace std;
 
+// Print the memory taken by the numTrials copies of agent a that runExperiment makes: the bytes each copy holds on its own (weights
+// and buffers), and the bytes all of the copies share (the basis).
+template <typename Agent>
+void reportAgentMemory(const Agent & a, const int & numTrials) {
+	const size_t perTrial = a.getTrialMemory(), shared = a.getSharedMemory();
+	cout << "Agent memory: " << perTrial << " bytes per trial, " << shared << " bytes shared by all " << numTrials << " trials ("
+		<< perTrial * numTrials + shared << " bytes in total, against " << (perTrial + shared) * numTrials << " without sharing)" << endl;
+}
+
 // This is a "templated" function. Here "Agent" and "Environment" can be any objects that allow this function to compile.
 // The compler will work out all objects "Agent" and "Environment" that this function is called with, and will compile
 // different versions for each. This allows us to pass different objects as the "Environment". See in runMountainCar
@@ -23,8 +32,14 @@ using namespace std;
 // the discounted returns for each episode number. That is, meanBuff's length is numEpisodes, and meanBuff[i] is the average
 // return on the i'th episode across the numTrials trials. varBuff[i] is the variance of the returns during the i'th episodes
 // from the numTrials trials.
+//
+// The last two arguments are optional. trialSeconds holds the run times of the trials of an earlier, similar experiment (e.g. the
+// previous point of a grid search, for the same agent and environment), which the scheduler uses to start the longest trials first.
+// When it is given, it is replaced by the run times of this experiment's trials, ready for the next one. verbose prints diagnostics
+// about the run (the utilization of the threads and the memory taken by the agents), which are left out by default so they do not
+// get mixed into the results that the grid searches print.
 template <typename Agent, typename Environment>
-void runExperiment(Agent & a, Environment & e, const int & numTrials, const int & numEpisodes, const int & maxEpisodeLength, const double & gamma, mt19937_64 & generator, vector<double> & meanBuff, vector<double> & varBuff) {
+void runExperiment(Agent & a, Environment & e, const int & numTrials, const int & numEpisodes, const int & maxEpisodeLength, const double & gamma, mt19937_64 & generator, vector<double> & meanBuff, vector<double> & varBuff, vector<double> * trialSeconds = nullptr, const bool & verbose = false) {
 	/*
 	This function is multithreaded. To avoid having two threads over-writing the same result locations in memory, we will create separate objects and places to store
 	results for every thread. We will have roughly one thread per trial (capped at your number of hyperthreads for your CPU).
@@ -35,28 +50,23 @@ void runExperiment(Agent & a, Environment & e, const int & numTrials, const int
 	vector<mt19937_64> generators(numTrials);		// Create numTrials random number generators. Don't make them all equal though! The loop below seeds them all differently.
 	for (int trial = 0; trial < numTrials; trial++)
 		generators[trial].seed(trial);
-	#pragma omp parallel for						// Ignore this line. It is the magic that makes the following for-loop happen in parallel.
-	for (int trial = 0; trial < numTrials; trial++) {	// Loop over trials
-		// std::printf("%d", trial);
-		returns[trial] = vector<double>(numEpisodes, 0.0);	// Resize the trial'th returns array to be of length numEpisodes, and set all entries equal to zero. (Recall the first line made returns a vector of length numTrials, essentially setting the number of rows - here we are setting the number of columns).
-		vector<double> state, nextState; // The current state and the next state, as vectors. Put outside loop to only allocate once
-		for (int episode = 0; episode < numEpisodes; episode++) {	// Loop over episodes
-			double curGamma = 1.0;					// We plot the discounted return - this stores gamma^t, which starts at 1.
-			bool inTerminalState = false;			// We will use this flag to determine when we should terminate the loop below. If environment[trial].inTerminalState() is slow to call, this saves us from calling it a couple times. For our MDPs it really doesn't matter that we're doing this more efficiently.
-			environments[trial].newEpisode(generators[trial]);	// Reset the environment, telling it to start a new episode.
-			agents[trial].newEpisode(generators[trial]);		// Tell the agent that we are starting a new episode. 
-			state = environments[trial].getState(generators[trial]);	// Get teh initial state.
-			for (int t = 0; (t < maxEpisodeLength) && (!inTerminalState); t++) {	// Loop over time steps in the episode, stopping when we hit the max episode length or when we enter a terminal state.
-				int action = agents[trial].getAction(state, generators[trial]);		// Get the current action
-				double reward = environments[trial].update(action, generators[trial]);	// Apply the action by updating the environment with the chosen action, and get the resulting reward.
-				returns[trial][episode] += curGamma * reward;							// Update the expected return for the current episode.
-				nextState = environments[trial].getState(generators[trial]);			// Get the resulting state of the environment from this transition
-				inTerminalState = environments[trial].inTerminalState();				// Store whether this is next-state is a terminal state.
-				agents[trial].train(generators[trial], state, action, reward, nextState, inTerminalState);	// Update the agent, telling it if "nextState" is a terminal state.
-				state = nextState;														// Prepare for the next iteration of the loop with this line and the next.
-				curGamma *= gamma;
-			}
-		}
+	// The trials are run by a work-stealing scheduler (see TrialScheduler.hpp) rather than by a plain OpenMP loop, because their
+	// run times vary a lot: each trial is cut into chunks of consecutive episodes, the longest trials (as measured in trialSeconds,
+	// if given) start first, and threads that run out of trials take over the ones that are waiting. Each trial still runs its
+	// episodes in order with its own agent, environment and generator, so the results do not depend on the schedule.
+	const int numChunks = min(numEpisodes, TrialScheduler::defaultChunksPerTrial);
+	vector<typename ObservationType<Agent, Environment>::type> states(numTrials), nextStates(numTrials); // The current state and the next state of each trial, in the type the agent and environment exchange (a vector, a SparseState, or a state id; see ObservationType.hpp). Kept across chunks to only allocate once
+	TrialScheduler scheduler(numTrials, numChunks, trialSeconds ? *trialSeconds : vector<double>());
+	scheduler.run([&](int trial, int chunk) {		// Run chunk "chunk" of trial "trial": episodes chunk*numEpisodes/numChunks up to (chunk+1)*numEpisodes/numChunks
+		if (chunk == 0)
+			returns[trial] = vector<double>(numEpisodes, 0.0);	// Resize the trial'th returns array to be of length numEpisodes, and set all entries equal to zero. (Recall the first line made returns a vector of length numTrials, essentially setting the number of rows - here we are setting the number of columns).
+		runTrialEpisodes(agents[trial], environments[trial], generators[trial], states[trial], nextStates[trial], chunk * numEpisodes / numChunks, (chunk + 1) * numEpisodes / numChunks, maxEpisodeLength, gamma, returns[trial]);	// The episodes of this chunk (see TrialEpisodes.hpp)
+	});
+	if (trialSeconds)
+		*trialSeconds = scheduler.getTrialSeconds();
+	if (verbose) {
+		scheduler.reportUtilization();
+		reportAgentMemory(agents[0], numTrials);	// Measured after the run, when the buffers have their final sizes
 	}
 	// Clear the two buffers that we will use for output, setting them both to be of length numEpisodes, and initialized to zero
 	meanBuff = varBuff = vector<double>(numEpisodes, 0.0);
@@ -69,6 +79,59 @@ void runExperiment(Agent & a, Environment & e, const int & numTrials, const int
 	}
 }
 
+// Write the results of one configuration of a grid search as the runXwParamQ and runXwParamS functions do, in the Q-learning columns or,
+// if sarsa is set, in the Sarsa ones, to "<numEpisodes>out_<name>-<parameters>-<final mean><agentName>.csv", and print the final mean.
+void writeParamResults(const string & name, const string & agentName, const bool & sarsa, double a, double g, double ee, int i, int d, const vector<double> & means, const vector<double> & vars) {
+	const int numEpisodes = (int)means.size();
+	const vector<double> zeros(numEpisodes, 0.0);
+	const vector<double> & means1 = sarsa ? zeros : means, & vars1 = sarsa ? zeros : vars;
+	const vector<double> & means2 = sarsa ? means : zeros, & vars2 = sarsa ? vars : zeros;
+	ofstream out("../../../output/"+to_string(numEpisodes)+"out_"+name+"-"+to_string(a)+"-"+to_string(g)+"-"+to_string(ee)+"-"+to_string(i)+"-"+to_string(d)+"-"+to_string(means[numEpisodes-1])+agentName+".csv");
+	out << "Number of Episodes,"
+		<< "Q-Learning,Sarsa,"
+		<< "Stddev Q-Learning,Stddev Sarsa" << endl;
+	for (int epCount = 0; epCount < numEpisodes; epCount++) {
+		out << epCount << ","
+			<< means1[epCount] << "," << means2[epCount] << "," 
+			<< sqrt(vars1[epCount]) << "," << sqrt(vars2[epCount]) << endl;
+	}
+	out.close();
+	cout << to_string(means[numEpisodes-1]);
+}
+
+// A grid search over alpha and epsilon for one gamma, iOrder and dOrder, run as one lockstep sweep (see runLockstepSweep in
+// LockstepRunner.hpp): every (alpha, epsilon) pair, alpha in the outer loop as in main, is a lane of one LockstepAgent (LockstepQLearning
+// or LockstepSarsa), and the numTrials trials each run all of the pairs side by side on BatchedEnvironment. The returns are those of
+// runExperiment for each pair, so the csv files and the printed final means are those of the runXwParamQ and runXwParamS functions
+// (see writeParamResults).
+template <typename LockstepAgent, typename BatchedEnvironment>
+void runLockstepGrid(const string & name, const string & agentName, const bool & sarsa, const vector<double> & as, double g, const vector<double> & es, int i, int d, const int & numTrials, const int & numEpisodes, const int & maxEpisodeLength) {
+	double gamma = 1.0;
+	vector<double> alphas, epsilons;
+	for (double a : as) {
+		for (double ee : es) {
+			alphas.push_back(a);
+			epsilons.push_back(ee);
+		}
+	}
+	BatchedEnvironment e((int)alphas.size());
+	LockstepAgent agent(e.getStateDim(), e.getNumActions(), alphas, g, epsilons, i, d);
+	vector<vector<vector<double>>> returns;
+	runLockstepSweep(agent, e, numTrials, numEpisodes, maxEpisodeLength, gamma, returns);
+	vector<double> cur(numTrials);
+	for (size_t c = 0; c < alphas.size(); c++) {
+		vector<double> means(numEpisodes), vars(numEpisodes);
+		for (int epCount = 0; epCount < numEpisodes; epCount++) {
+			for (int trial = 0; trial < numTrials; trial++)
+				cur[trial] = returns[c][trial][epCount];
+			means[epCount] = mean(cur);
+			vars[epCount] = var(cur);
+		}
+		cout << endl << "out-"+to_string(alphas[c])+"-"+to_string(g)+"-"+to_string(epsilons[c])+"-"+to_string(i)+"-"+to_string(d) << endl;
+		writeParamResults(name, agentName, sarsa, alphas[c], g, epsilons[c], i, d, means, vars);
+	}
+}
+
 // Run Q-learning and Sarsa on Mountain Car.
 void runMountainCar() {
 	mt19937_64 generator(0);	// Create the random number generator.
@@ -76,17 +139,15 @@ void runMountainCar() {
 	MountainCar e;				// Create the environment object, in this case a MountainCar object.
 	double gamma = 1.0;			// Plot expected returns with this value of gamma (you might use the same parameter in your agent, or you might not!)
 	
-	// Create the two agents. The arguments here are the hyperparameters that you must tune! The ones we provide you below
-	// are bad first examples.
-	//													alpha		gamma	epsilon	iOrder	dOrder
-	QLearning a1(e.getStateDim(), e.getNumActions(),	0.00001,	0,		1,		1,		1);
-	Sarsa a2(e.getStateDim(), e.getNumActions(),		70,			1,		0.95,	5,		0);
-	
-	// Run each agent on the mountain car environment using the runEnvironment function (see above for a description of what it stores in the last
-	// two arguments (means and vars).
 	vector<double> means1, vars1, means2, vars2;
-	runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1);
-	runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2);
+
+	// Create the two agents, and run each on the mountain car environment using the runEnvironment function (see above for a description
+	// of what it stores in the last two arguments (means and vars). The arguments here are the hyperparameters that you must tune! The ones
+	// we provide you below are bad first examples. When a compile-time specialized agent is prebuilt for the chosen orders, it is used
+	// instead of QLearning or Sarsa, with the same results (see AgentDispatch.hpp).
+	//													alpha		gamma	epsilon	iOrder	dOrder
+	withQLearningAgent(e.getStateDim(), e.getNumActions(),	0.00001,	0,		1,		1,		1,	[&](auto & a1) { runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1); });
+	withSarsaAgent(e.getStateDim(), e.getNumActions(),		70,			1,		0.95,	5,		0,	[&](auto & a2) { runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2); });
 
 	// Dump the results of the experiment to an output csv file. The first column will be the episode number, the second will be the mean
 	// discounted return for Q-learning, the third column will be the mean discounted return for Sarsa, the fourth column will be the standard
@@ -104,26 +165,25 @@ void runMountainCar() {
 	out.close();
 }
 
-// Run Q-learning and Sarsa on Mountain Car.
-void runMountainCarwParamQ(double a, double g, double ee, int i, int d) {
+// Run Q-learning and Sarsa on Mountain Car. trialSeconds is passed on to runExperiment: a grid search keeps one for all of its
+// points, so each point starts the trials that took longest at the previous one first.
+void runMountainCarwParamQ(double a, double g, double ee, int i, int d, vector<double> * trialSeconds = nullptr) {
 	mt19937_64 generator(0);	// Create the random number generator.
 	int numTrials = 100, numEpisodes = 40, maxEpisodeLength = 20000;	// numTrials = number of agent lifetimes, numEpisodes is the number of episodes in an agent lifetime, and episodes are always terminated if they reach time step maxEpisodeLength.
 	MountainCar e;				// Create the environment object, in this case a MountainCar object.
 	double gamma = 1.0;			// Plot expected returns with this value of gamma (you might use the same parameter in your agent, or you might not!)
 	
-	// Create the two agents. The arguments here are the hyperparameters that you must tune! The ones we provide you below
-	// are bad first examples.
-	//													alpha		gamma	epsilon	iOrder	dOrder
-	QLearning a1(e.getStateDim(), e.getNumActions(),	a,g,ee,i,d);
-	Sarsa a2(e.getStateDim(), e.getNumActions(),		a,g,ee,i,d);
-	
-	// Run each agent on the mountain car environment using the runEnvironment function (see above for a description of what it stores in the last
-	// two arguments (means and vars).
 	vector<double> means1, vars1;
 	vector<double> means2(numEpisodes,0.0);
 	vector<double> vars2(numEpisodes,0.0);
-	runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1);
-	// runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2);
+
+	// Create the two agents, and run each on the mountain car environment using the runEnvironment function (see above for a description
+	// of what it stores in the last two arguments (means and vars). The arguments here are the hyperparameters that you must tune! The ones
+	// we provide you below are bad first examples. When a compile-time specialized agent is prebuilt for the chosen orders, it is used
+	// instead of QLearning or Sarsa, with the same results (see AgentDispatch.hpp).
+	//													alpha		gamma	epsilon	iOrder	dOrder
+	withQLearningAgent(e.getStateDim(), e.getNumActions(),	a,g,ee,i,d,	[&](auto & a1) { runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1, trialSeconds); });
+	// withSarsaAgent(e.getStateDim(), e.getNumActions(),		a,g,ee,i,d,	[&](auto & a2) { runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2, trialSeconds); });
 
 	// Dump the results of the experiment to an output csv file. The first column will be the episode number, the second will be the mean
 	// discounted return for Q-learning, the third column will be the mean discounted return for Sarsa, the fourth column will be the standard
@@ -143,25 +203,23 @@ void runMountainCarwParamQ(double a, double g, double ee, int i, int d) {
 }
 
 // Run Q-learning and Sarsa on Mountain Car.
-void runMountainCarwParamS(double a, double g, double ee, int i, int d) {
+void runMountainCarwParamS(double a, double g, double ee, int i, int d, vector<double> * trialSeconds = nullptr) {
 	mt19937_64 generator(0);	// Create the random number generator.
 	int numTrials = 100, numEpisodes = 40, maxEpisodeLength = 20000;	// numTrials = number of agent lifetimes, numEpisodes is the number of episodes in an agent lifetime, and episodes are always terminated if they reach time step maxEpisodeLength.
 	MountainCar e;				// Create the environment object, in this case a MountainCar object.
 	double gamma = 1.0;			// Plot expected returns with this value of gamma (you might use the same parameter in your agent, or you might not!)
 	
-	// Create the two agents. The arguments here are the hyperparameters that you must tune! The ones we provide you below
-	// are bad first examples.
-	//													alpha		gamma	epsilon	iOrder	dOrder
-	QLearning a1(e.getStateDim(), e.getNumActions(),	a,g,ee,i,d);
-	Sarsa a2(e.getStateDim(), e.getNumActions(),		a,g,ee,i,d);
-	
-	// Run each agent on the mountain car environment using the runEnvironment function (see above for a description of what it stores in the last
-	// two arguments (means and vars).
 	vector<double> means2, vars2;
 	vector<double> means1(numEpisodes,0.0);
 	vector<double> vars1(numEpisodes,0.0);
-	// runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1);
-	runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2);
+
+	// Create the two agents, and run each on the mountain car environment using the runEnvironment function (see above for a description
+	// of what it stores in the last two arguments (means and vars). The arguments here are the hyperparameters that you must tune! The ones
+	// we provide you below are bad first examples. When a compile-time specialized agent is prebuilt for the chosen orders, it is used
+	// instead of QLearning or Sarsa, with the same results (see AgentDispatch.hpp).
+	//													alpha		gamma	epsilon	iOrder	dOrder
+	// withQLearningAgent(e.getStateDim(), e.getNumActions(),	a,g,ee,i,d,	[&](auto & a1) { runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1, trialSeconds); });
+	withSarsaAgent(e.getStateDim(), e.getNumActions(),		a,g,ee,i,d,	[&](auto & a2) { runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2, trialSeconds); });
 
 	// Dump the results of the experiment to an output csv file. The first column will be the episode number, the second will be the mean
 	// discounted return for Q-learning, the third column will be the mean discounted return for Sarsa, the fourth column will be the standard
@@ -186,12 +244,10 @@ void runCartPole() {
 	int numTrials = 50, numEpisodes = 50, maxEpisodeLength = INT_MAX;
 	CartPole e;
 	double gamma = 1.0;
-	//													alpha		gamma	epsilon	iOrder	dOrder
-	QLearning a1(e.getStateDim(), e.getNumActions(),	0.00001,	0,		1,		1,		1);
-	Sarsa a2(e.getStateDim(), e.getNumActions(),		70,			1,		0.95,	4,		0);
 	vector<double> means1, vars1, means2, vars2;
-	runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1);
-	runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2);
+	//													alpha		gamma	epsilon	iOrder	dOrder
+	withQLearningAgent(e.getStateDim(), e.getNumActions(),	0.00001,	0,		1,		1,		1,	[&](auto & a1) { runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1); });
+	withSarsaAgent(e.getStateDim(), e.getNumActions(),		70,			1,		0.95,	4,		0,	[&](auto & a2) { runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2); });
 	ofstream out("../../../output/out_CartPole.csv");
 	out << "Number of Episodes,"
 		<< "Q-Learning,Sarsa,"
@@ -205,19 +261,17 @@ void runCartPole() {
 }
 
 // See runMountainCar: This is the same thing, but for the CartPole environment.
-void runCartPolewParamQ(double a, double g, double ee, int i, int d) {
+void runCartPolewParamQ(double a, double g, double ee, int i, int d, vector<double> * trialSeconds = nullptr) {
 	mt19937_64 generator(0);
 	int numTrials = 50, numEpisodes = 50, maxEpisodeLength = INT_MAX;
 	CartPole e;
 	double gamma = 1.0;
-	//													alpha		gamma	epsilon	iOrder	dOrder
-	QLearning a1(e.getStateDim(), e.getNumActions(),	a,g,ee,i,d);
-	Sarsa a2(e.getStateDim(), e.getNumActions(),		a,g,ee,i,d);
 	vector<double> means1, vars1;
 	vector<double> means2(numEpisodes,0.0);
 	vector<double> vars2(numEpisodes,0.0);
-	runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1);
-	// runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2);
+	//													alpha		gamma	epsilon	iOrder	dOrder
+	withQLearningAgent(e.getStateDim(), e.getNumActions(),	a,g,ee,i,d,	[&](auto & a1) { runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1, trialSeconds); });
+	// withSarsaAgent(e.getStateDim(), e.getNumActions(),		a,g,ee,i,d,	[&](auto & a2) { runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2, trialSeconds); });
 	ofstream out("../../../output/"+to_string(numEpisodes)+"out_CartPole-"+to_string(a)+"-"+to_string(g)+"-"+to_string(ee)+"-"+to_string(i)+"-"+to_string(d)+"-"+to_string(means1[numEpisodes-1])+"qlearning.csv");
 	out << "Number of Episodes,"
 		<< "Q-Learning,Sarsa,"
@@ -232,19 +286,17 @@ void runCartPolewParamQ(double a, double g, double ee, int i, int d) {
 }
 
 // See runMountainCar: This is the same thing, but for the CartPole environment.
-void runCartPolewParamS(double a, double g, double ee, int i, int d) {
+void runCartPolewParamS(double a, double g, double ee, int i, int d, vector<double> * trialSeconds = nullptr) {
 	mt19937_64 generator(0);
 	int numTrials = 50, numEpisodes = 50, maxEpisodeLength = INT_MAX;
 	CartPole e;
 	double gamma = 1.0;
-	//													alpha		gamma	epsilon	iOrder	dOrder
-	QLearning a1(e.getStateDim(), e.getNumActions(),	a,g,ee,i,d);
-	Sarsa a2(e.getStateDim(), e.getNumActions(),		a,g,ee,i,d);
 	vector<double> means2, vars2;
 	vector<double> means1(numEpisodes,0.0);
 	vector<double> vars1(numEpisodes,0.0);
-	// runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1);
-	runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2);
+	//													alpha		gamma	epsilon	iOrder	dOrder
+	// withQLearningAgent(e.getStateDim(), e.getNumActions(),	a,g,ee,i,d,	[&](auto & a1) { runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1, trialSeconds); });
+	withSarsaAgent(e.getStateDim(), e.getNumActions(),		a,g,ee,i,d,	[&](auto & a2) { runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2, trialSeconds); });
 	ofstream out("../../../output/"+to_string(numEpisodes)+"out_CartPole-"+to_string(a)+"-"+to_string(g)+"-"+to_string(ee)+"-"+to_string(i)+"-"+to_string(d)+"-"+to_string(means2[numEpisodes-1])+"sarsa.csv");
 	out << "Number of Episodes,"
 		<< "Q-Learning,Sarsa,"
@@ -264,12 +316,10 @@ void runAcrobot() {
 	int numTrials = 100, numEpisodes = 100, maxEpisodeLength = 3000;
 	double gamma = 1.0;
 	Acrobot e;
-	//													alpha		gamma	epsilon	iOrder	dOrder
-	QLearning a1(e.getStateDim(), e.getNumActions(),	0.00001,	0,		1,		1,		1);
-	Sarsa a2(e.getStateDim(), e.getNumActions(),		70,			1,		0.95,	2,		0);
 	vector<double> means1, vars1, means2, vars2;
-	runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1);
-	runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2);
+	//													alpha		gamma	epsilon	iOrder	dOrder
+	withQLearningAgent(e.getStateDim(), e.getNumActions(),	0.00001,	0,		1,		1,		1,	[&](auto & a1) { runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1); });
+	withSarsaAgent(e.getStateDim(), e.getNumActions(),		70,			1,		0.95,	2,		0,	[&](auto & a2) { runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2); });
 	ofstream out("../../../output/out_Acrobot.csv");
 	out << "Number of Episodes,"
 		<< "Q-Learning,Sarsa,"
@@ -283,19 +333,17 @@ void runAcrobot() {
 }
 
 // See runMountainCar: This is the same thing, but for the Acrobot environment.
-void runAcrobotwParamQ(double a, double g, double ee, int i, int d) {
+void runAcrobotwParamQ(double a, double g, double ee, int i, int d, vector<double> * trialSeconds = nullptr) {
 	mt19937_64 generator(0);
 	int numTrials = 100, numEpisodes = 100, maxEpisodeLength = 3000;
 	double gamma = 1.0;
 	Acrobot e;
-	//													alpha		gamma	epsilon	iOrder	dOrder
-	QLearning a1(e.getStateDim(), e.getNumActions(),	a,g,ee,i,d);
-	Sarsa a2(e.getStateDim(), e.getNumActions(),		a,g,ee,i,d);
 	vector<double> means1, vars1;
 	vector<double> means2(numEpisodes,0.0);
 	vector<double> vars2(numEpisodes,0.0);
-	runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1);
-	// runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2);
+	//													alpha		gamma	epsilon	iOrder	dOrder
+	withQLearningAgent(e.getStateDim(), e.getNumActions(),	a,g,ee,i,d,	[&](auto & a1) { runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1, trialSeconds); });
+	// withSarsaAgent(e.getStateDim(), e.getNumActions(),		a,g,ee,i,d,	[&](auto & a2) { runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2, trialSeconds); });
 	ofstream out("../../../output/"+to_string(numEpisodes)+"out_Acrobot-"+to_string(a)+"-"+to_string(g)+"-"+to_string(ee)+"-"+to_string(i)+"-"+to_string(d)+"-"+to_string(means1[numEpisodes-1])+"qlearning.csv");
 	out << "Number of Episodes,"
 		<< "Q-Learning,Sarsa,"
@@ -310,19 +358,17 @@ void runAcrobotwParamQ(double a, double g, double ee, int i, int d) {
 }
 
 // See runMountainCar: This is the same thing, but for the Acrobot environment.
-void runAcrobotwParamS(double a, double g, double ee, int i, int d) {
+void runAcrobotwParamS(double a, double g, double ee, int i, int d, vector<double> * trialSeconds = nullptr) {
 	mt19937_64 generator(0);
 	int numTrials = 100, numEpisodes = 100, maxEpisodeLength = 3000;
 	double gamma = 1.0;
 	Acrobot e;
-	//													alpha		gamma	epsilon	iOrder	dOrder
-	QLearning a1(e.getStateDim(), e.getNumActions(),	a,g,ee,i,d);
-	Sarsa a2(e.getStateDim(), e.getNumActions(),		a,g,ee,i,d);
 	vector<double> means2, vars2;
 	vector<double> means1(numEpisodes,0.0);
 	vector<double> vars1(numEpisodes,0.0);
-	// runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1);
-	runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2);
+	//													alpha		gamma	epsilon	iOrder	dOrder
+	// withQLearningAgent(e.getStateDim(), e.getNumActions(),	a,g,ee,i,d,	[&](auto & a1) { runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1, trialSeconds); });
+	withSarsaAgent(e.getStateDim(), e.getNumActions(),		a,g,ee,i,d,	[&](auto & a2) { runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2, trialSeconds); });
 	ofstream out("../../../output/"+to_string(numEpisodes)+"out_Acrobot-"+to_string(a)+"-"+to_string(g)+"-"+to_string(ee)+"-"+to_string(i)+"-"+to_string(d)+"-"+to_string(means2[numEpisodes-1])+"sarsa.csv");
 	out << "Number of Episodes,"
 		<< "Q-Learning,Sarsa,"
@@ -336,6 +382,69 @@ void runAcrobotwParamS(double a, double g, double ee, int i, int d) {
 	cout << to_string(means2[numEpisodes-1]);
 }
 
+// Grid searches over as x es, with the trial counts and episode lengths of runMountainCarwParamQ, runCartPolewParamQ and
+// runAcrobotwParamQ, each as one lockstep sweep per agent (see runLockstepGrid) instead of as.size()*es.size() calls of those.
+void runMountainCarSweep(const vector<double> & as, double g, const vector<double> & es, int i, int d) {
+	runLockstepGrid<LockstepQLearning, BatchedMountainCar>("Mountain", "qlearning", false, as, g, es, i, d, 100, 40, 20000);
+	runLockstepGrid<LockstepSarsa, BatchedMountainCar>("Mountain", "sarsa", true, as, g, es, i, d, 100, 40, 20000);
+}
+
+void runCartPoleSweep(const vector<double> & as, double g, const vector<double> & es, int i, int d) {
+	runLockstepGrid<LockstepQLearning, BatchedCartPole>("CartPole", "qlearning", false, as, g, es, i, d, 50, 50, INT_MAX);
+	runLockstepGrid<LockstepSarsa, BatchedCartPole>("CartPole", "sarsa", true, as, g, es, i, d, 50, 50, INT_MAX);
+}
+
+void runAcrobotSweep(const vector<double> & as, double g, const vector<double> & es, int i, int d) {
+	runLockstepGrid<LockstepQLearning, BatchedAcrobot>("Acrobot", "qlearning", false, as, g, es, i, d, 100, 100, 3000);
+	runLockstepGrid<LockstepSarsa, BatchedAcrobot>("Acrobot", "sarsa", true, as, g, es, i, d, 100, 100, 3000);
+}
+
+// The whole grid as one flattened sweep (see SweepEngine.hpp): every (alpha, gamma, epsilon, iOrder, dOrder) point, for Q-learning and
+// for Sarsa, is queued as numTrials trial tasks on the persistent thread pool, and the csv file of each point is written as soon as
+// its last trial finishes. There is no barrier between the points, so the threads stay busy until the last trial of the sweep. The
+// files and results are those of calling runXwParamQ and runXwParamS for each point (see writeParamResults), but they come out in
+// the order the points finish.
+template <typename Environment>
+void runGridSweep(const string & name, const vector<double> & as, const vector<double> & gs, const vector<double> & es, const vector<int> & is, const vector<int> & ds, const int & numTrials, const int & numEpisodes, const int & maxEpisodeLength) {
+	Environment e;
+	double gamma = 1.0;
+	SweepEngine engine;
+	for (double a : as) {
+		for (double g : gs) {
+			for (double ee : es) {
+				for (int i : is) {
+					for (int d : ds) {
+						const string run = "out-"+to_string(a)+"-"+to_string(g)+"-"+to_string(ee)+"-"+to_string(i)+"-"+to_string(d);
+						withQLearningAgent(e.getStateDim(), e.getNumActions(),	a,g,ee,i,d,	[&](auto & a1) { engine.add(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, [=](const vector<double> & means, const vector<double> & vars) {
+							cout << endl << run << endl;
+							writeParamResults(name, "qlearning", false, a, g, ee, i, d, means, vars);
+						}); });
+						withSarsaAgent(e.getStateDim(), e.getNumActions(),		a,g,ee,i,d,	[&](auto & a2) { engine.add(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, [=](const vector<double> & means, const vector<double> & vars) {
+							cout << endl << run << endl;
+							writeParamResults(name, "sarsa", true, a, g, ee, i, d, means, vars);
+						}); });
+					}
+				}
+			}
+		}
+	}
+	engine.wait();
+}
+
+// Flattened sweeps over the grid, with the trial counts and episode lengths of runMountainCarwParamQ, runCartPolewParamQ and
+// runAcrobotwParamQ.
+void runMountainCarGrid(const vector<double> & as, const vector<double> & gs, const vector<double> & es, const vector<int> & is, const vector<int> & ds) {
+	runGridSweep<MountainCar>("Mountain", as, gs, es, is, ds, 100, 40, 20000);
+}
+
+void runCartPoleGrid(const vector<double> & as, const vector<double> & gs, const vector<double> & es, const vector<int> & is, const vector<int> & ds) {
+	runGridSweep<CartPole>("CartPole", as, gs, es, is, ds, 50, 50, INT_MAX);
+}
+
+void runAcrobotGrid(const vector<double> & as, const vector<double> & gs, const vector<double> & es, const vector<int> & is, const vector<int> & ds) {
+	runGridSweep<Acrobot>("Acrobot", as, gs, es, is, ds, 100, 100, 3000);
+}
+
 // See runMountainCar: This is the same thing, but for the Gridworld environment.
 void runGridworld() {
 	mt19937_64 generator(0);
@@ -362,8 +471,60 @@ void runGridworld() {
 	out.close();
 }
 
+// runGridworld with the tabular agents, which take the state id and make a step a couple of table lookups. They learn on an
+// actual table rather than on the Fourier features of the one-hot states, so the returns differ from runGridworld's.
+void runGridworldTabular() {
+	mt19937_64 generator(0);
+	int numTrials = 100, numEpisodes = 20, maxEpisodeLength = 1000;
+	double gamma = 1.0;
+	Gridworld e;
+	//															alpha		gamma	epsilon
+	TabularQLearning a1(e.getNumStates(), e.getNumActions(),	0.01,		1,		0.1);
+	TabularSarsa a2(e.getNumStates(), e.getNumActions(),		70,			1,		0.95);
+	vector<double> means1, vars1, means2, vars2;
+	runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1);
+	runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2);
+	ofstream out("../../../output/out_GridworldTabular.csv");
+	out << "Number of Episodes,"
+		<< "Q-Learning,Sarsa,"
+		<< "Stddev Q-Learning,Stddev Sarsa" << endl;
+	for (int epCount = 0; epCount < numEpisodes; epCount++) {
+		out << epCount << ","
+			<< means1[epCount] << "," << means2[epCount] << "," 
+			<< sqrt(vars1[epCount]) << "," << sqrt(vars2[epCount]) << endl;
+	}
+	out.close();
+}
+
+// runGridworld on a map loaded from path (see GridMap.hpp for the text and binary formats). The map is held once for all of the
+// trials, and the agents use a PagedQTable, so only the states they update take memory: maps far too large for a dense table (up
+// to INT_MAX cells) can be used.
+void runGridworldMap(const string & path) {
+	mt19937_64 generator(0);
+	int numTrials = 100, numEpisodes = 20, maxEpisodeLength = 100000;
+	double gamma = 1.0;
+	Gridworld e(make_shared<GridMap>(GridMap::load(path)));
+	cout << "Map: " << e.getMap().getWidth() << "x" << e.getMap().getHeight() << ", " << e.getMap().getMemory() << " bytes" << endl;
+	//																alpha		gamma	epsilon
+	PagedTabularQLearning a1(e.getNumStates(), e.getNumActions(),	0.01,		1,		0.1);
+	PagedTabularSarsa a2(e.getNumStates(), e.getNumActions(),		0.01,		1,		0.1);
+	vector<double> means1, vars1, means2, vars2;
+	runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1);
+	runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2);
+	ofstream out("../../../output/out_GridworldMap.csv");
+	out << "Number of Episodes,"
+		<< "Q-Learning,Sarsa,"
+		<< "Stddev Q-Learning,Stddev Sarsa" << endl;
+	for (int epCount = 0; epCount < numEpisodes; epCount++) {
+		out << epCount << ","
+			<< means1[epCount] << "," << means2[epCount] << "," 
+			<< sqrt(vars1[epCount]) << "," << sqrt(vars2[epCount]) << endl;
+	}
+	out.close();
+}
+
 // See runMountainCar: This is the same thing, but for the Gridworld environment.
-void runGridworldwParamQ(double a, double g, double ee, int i, int d) {
+void runGridworldwParamQ(double a, double g, double ee, int i, int d, vector<double> * trialSeconds = nullptr) {
 	mt19937_64 generator(0);
 	int numTrials = 100, numEpisodes = 20, maxEpisodeLength = 1000;
 	double gamma = 1.0;
@@ -377,8 +538,8 @@ void runGridworldwParamQ(double a, double g, double ee, int i, int d) {
 	vector<double> means2(numEpisodes,0.0);
 	vector<double> vars2(numEpisodes,0.0);
 	// Disable QLearning
-	runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1);
-	// runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2);
+	runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1, trialSeconds);
+	// runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2, trialSeconds);
 	printf("Writing csv...");
 	ofstream out("../../../output/"+to_string(numEpisodes)+"out_Gridworld-"+to_string(a)+"-"+to_string(g)+"-"+to_string(ee)+"-"+to_string(i)+"-"+to_string(d)+"-"+to_string(means1[numEpisodes-1])+"qlearning.csv");
 	out << "Number of Episodes,"
@@ -393,7 +554,7 @@ void runGridworldwParamQ(double a, double g, double ee, int i, int d) {
 	cout << to_string(means1[numEpisodes-1]);
 }
 // See runMountainCar: This is the same thing, but for the Gridworld environment.
-void runGridworldwParamS(double a, double g, double ee, int i, int d) {
+void runGridworldwParamS(double a, double g, double ee, int i, int d, vector<double> * trialSeconds = nullptr) {
 	mt19937_64 generator(0);
 	int numTrials = 100, numEpisodes = 20, maxEpisodeLength = 1000;
 	double gamma = 1.0;
@@ -407,8 +568,8 @@ void runGridworldwParamS(double a, double g, double ee, int i, int d) {
 	vector<double> means1(numEpisodes,0.0);
 	vector<double> vars1(numEpisodes,0.0);
 	// Disable QLearning
-	// runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1);
-	runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2);
+	// runExperiment(a1, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means1, vars1, trialSeconds);
+	runExperiment(a2, e, numTrials, numEpisodes, maxEpisodeLength, gamma, generator, means2, vars2, trialSeconds);
 	printf("Writing csv...");
 	ofstream out("../../../output/"+to_string(numEpisodes)+"out_Gridworld-"+to_string(a)+"-"+to_string(g)+"-"+to_string(ee)+"-"+to_string(i)+"-"+to_string(d)+"-"+to_string(means2[numEpisodes-1])+"sarsa.csv");
 	out << "Number of Episodes,"
@@ -426,6 +587,22 @@ void runGridworldwParamS(double a, double g, double ee, int i, int d) {
 // Entry point for the program. We won't use the arguments this time.
 int main(int argc, char * argv[])
 {
+	// "--benchmark <name>" runs one of the micro-benchmarks in Benchmarks.cpp instead of the experiments below.
+	if ((argc > 2) && (string(argv[1]) == "--benchmark")) {
+		if (!runBenchmark(argv[2])) {
+			cout << "Unknown benchmark: " << argv[2] << endl;
+			return 1;
+		}
+		return 0;
+	}
+	// "--check-allocations" checks that the agents' steady-state steps do not allocate (see checkAllocations in Benchmarks.hpp).
+	if ((argc > 1) && (string(argv[1]) == "--check-allocations"))
+		return checkAllocations() ? 0 : 1;
+	// "--gridmap <path>" runs the Gridworld agents on the map in that file (see runGridworldMap).
+	if ((argc > 2) && (string(argv[1]) == "--gridmap")) {
+		runGridworldMap(argv[2]);
+		return 0;
+	}
 	// cout << "Starting Mountain Car runs..." << endl;
 	// runMountainCar();	// Run the mountain car experiments (see the function above). The lines below are similar, but for other MDPs.
 	// cout << "\tDone.\nStarting Cart Pole runs..." << endl;
@@ -434,6 +611,7 @@ int main(int argc, char * argv[])
 	// runAcrobot();
 	// cout << "\tDone.\nStarting Gridworld runs..." << endl;
 	// runGridworld();
+	// runGridworldTabular();	// The same, with the tabular agents
 
 	// 0.00001, 0.001, 0.1, 1, 10
 	// vector<double> as = vector<double>{0.00001, 0.001, 0.1, 1, 10};
@@ -458,6 +636,7 @@ int main(int argc, char * argv[])
 	vector<double> es = vector<double>{0.1};
 	vector<int> is = vector<int>{3};
 	vector<int> ds = vector<int>{0};
+	vector<double> trialSeconds;	// The run times of the trials of the previous point (see runExperiment)
 	for (double a : as) {
 		for (double g : gs) {
 			for (double ee : es) {
@@ -465,12 +644,20 @@ int main(int argc, char * argv[])
 					for (int d : ds) {
 						string run = "out-"+to_string(a)+"-"+to_string(g)+"-"+to_string(ee)+"-"+to_string(i)+"-"+to_string(d);
 						cout << endl << run << endl;
-						runGridworldwParamQ(a,g,ee,i,d);
+						runGridworldwParamQ(a,g,ee,i,d,&trialSeconds);
 					}
 				}
 			}
 		}
 	}
+	// For MountainCar, CartPole and Acrobot, the alpha and epsilon loops can run as one lockstep sweep per (gamma, iOrder, dOrder),
+	// which trains every (alpha, epsilon) pair side by side and writes the same files:
+	// for (double g : gs)
+	//	for (int i : is)
+	//		for (int d : ds)
+	//			runMountainCarSweep(as, g, es, i, d);
+	// Or the whole grid, for Q-learning and Sarsa, as one flattened sweep with no barrier between the points:
+	// runMountainCarGrid(as, gs, es, is, ds);
 	
 }
 